@@ -0,0 +1,57 @@
+#pragma once
+
+#include "vector.h"
+
+#include <cstddef>
+#include <limits>
+#include <new>
+
+inline constexpr size_t CACHE_LINE_SIZE = 64;
+
+// Allocator returning buffers aligned to at least Alignment bytes through the
+// aligned operator new, so SIMD kernels can use aligned loads on the data of
+// e.g. AlignedVector<float, 64> (AVX-512). Over-aligned T are always aligned
+// to alignof(T).
+template <typename T, size_t Alignment = CACHE_LINE_SIZE>
+struct AlignedAllocator {
+    static_assert(Alignment > 0 && (Alignment & (Alignment - 1)) == 0, "Alignment must be a power of two");
+
+    using value_type = T;
+
+    static constexpr size_t ALIGNMENT = Alignment > alignof(T) ? Alignment : alignof(T);
+
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() noexcept = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {
+    }
+
+    T* allocate(size_t n) {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(operator new(n * sizeof(T), std::align_val_t{ALIGNMENT}));
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        operator delete(p, n * sizeof(T), std::align_val_t{ALIGNMENT});
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept {
+        return false;
+    }
+};
+
+template <typename T, size_t Alignment = CACHE_LINE_SIZE, typename Growth = DoublingGrowth<>>
+using AlignedVector = Vector<T, AlignedAllocator<T, Alignment>, Growth>;
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "vector.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+
+// Monotonic arena for batches of short-lived containers: allocation bumps a
+// pointer inside the current block, deallocation does nothing and Release()
+// frees every block at once. Blocks start at initial_block_bytes and double
+// in size. The arena must outlive the containers using it and is not thread
+// safe.
+class MonotonicArena {
+public:
+    static constexpr size_t DEFAULT_BLOCK_BYTES = 64 * 1024;
+
+    explicit MonotonicArena(size_t initial_block_bytes = DEFAULT_BLOCK_BYTES) noexcept
+        : next_block_bytes_(std::max<size_t>(initial_block_bytes, 1))
+    {
+    }
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    ~MonotonicArena() {
+        Release();
+    }
+
+    void* Allocate(size_t bytes, size_t alignment) {
+        uintptr_t start = AlignUp(cursor_, alignment);
+        if (cursor_ == 0 || start > end_ || bytes > end_ - start) {
+            AddBlock(bytes, alignment);
+            start = AlignUp(cursor_, alignment);
+        }
+        cursor_ = start + bytes;
+        used_bytes_ += bytes;
+        return reinterpret_cast<void*>(start);
+    }
+
+    // Grows the allocation at p from old_bytes to new_bytes when it is the
+    // most recent one and the current block has room after it
+    bool TryExpand(void* p, size_t old_bytes, size_t new_bytes) noexcept {
+        const uintptr_t start = reinterpret_cast<uintptr_t>(p);
+        if (p == nullptr || start + old_bytes != cursor_ || new_bytes < old_bytes || new_bytes > end_ - start) {
+            return false;
+        }
+        cursor_ = start + new_bytes;
+        used_bytes_ += new_bytes - old_bytes;
+        return true;
+    }
+
+    // Frees every block. Memory handed out before becomes invalid.
+    void Release() noexcept {
+        while (blocks_ != nullptr) {
+            Block* prev = blocks_->prev;
+            operator delete(blocks_);
+            blocks_ = prev;
+        }
+        cursor_ = 0;
+        end_ = 0;
+        used_bytes_ = 0;
+        reserved_bytes_ = 0;
+    }
+
+    // Bytes handed out since the last Release(), including abandoned buffers
+    size_t UsedBytes() const noexcept {
+        return used_bytes_;
+    }
+
+    // Bytes held in blocks
+    size_t ReservedBytes() const noexcept {
+        return reserved_bytes_;
+    }
+
+private:
+    // Keeps the first allocation of a block aligned like operator new
+    struct alignas(std::max_align_t) Block {
+        Block* prev;
+    };
+
+    Block* blocks_ = nullptr;
+    uintptr_t cursor_ = 0;
+    uintptr_t end_ = 0;
+    size_t next_block_bytes_;
+    size_t used_bytes_ = 0;
+    size_t reserved_bytes_ = 0;
+
+    static uintptr_t AlignUp(uintptr_t value, size_t alignment) noexcept {
+        return (value + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+    }
+
+    void AddBlock(size_t bytes, size_t alignment) {
+        // Over-aligned allocations may need padding after the block header
+        const size_t padding = alignment > alignof(Block) ? alignment : 0;
+        if (bytes > std::numeric_limits<size_t>::max() - sizeof(Block) - padding) {
+            throw std::bad_alloc();
+        }
+        const size_t data_bytes = std::max(next_block_bytes_, bytes + padding);
+        void* memory = operator new(sizeof(Block) + data_bytes);
+        blocks_ = new (memory) Block{blocks_};
+        cursor_ = reinterpret_cast<uintptr_t>(blocks_ + 1);
+        end_ = cursor_ + data_bytes;
+        reserved_bytes_ += data_bytes;
+        if (next_block_bytes_ <= std::numeric_limits<size_t>::max() / 2) {
+            next_block_bytes_ *= 2;
+        }
+    }
+};
+
+// Allocator drawing from a MonotonicArena. deallocate() is a no-op, and
+// Vector grows a buffer in place through expand_in_place() while it is the
+// arena's most recent allocation.
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(MonotonicArena& arena) noexcept
+        : arena_(&arena)
+    {
+    }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+        : arena_(&other.GetArena())
+    {
+    }
+
+    T* allocate(size_t n) {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(arena_->Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t) noexcept {
+    }
+
+    bool expand_in_place(T* p, size_t old_n, size_t new_n) noexcept {
+        if (new_n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            return false;
+        }
+        return arena_->TryExpand(p, old_n * sizeof(T), new_n * sizeof(T));
+    }
+
+    MonotonicArena& GetArena() const noexcept {
+        return *arena_;
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept {
+        return arena_ == &other.GetArena();
+    }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const noexcept {
+        return !(*this == other);
+    }
+
+private:
+    MonotonicArena* arena_;
+};
+
+template <typename T, typename Growth = DoublingGrowth<>>
+using ArenaVector = Vector<T, ArenaAllocator<T>, Growth>;
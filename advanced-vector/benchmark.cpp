@@ -0,0 +1,858 @@
+// Micro-benchmarks comparing Vector against std::vector.
+//
+//     g++ -std=c++17 -O2 -DNDEBUG benchmark.cpp -o benchmark
+//     ./benchmark [--filter=<substring>] [--max-size=<n>] [--min-time=<seconds>] [--csv]
+//                 [--simd=scalar|sse2|avx2|avx512|neon]
+//
+// Every benchmark is run for element types int, a 64-byte POD, std::string and
+// a type whose move constructor is not noexcept, at sizes from 8 up to
+// --max-size (10^8 is the largest size in the sweep). Reported per iteration:
+// wall time, heap allocations, allocated bytes and (on Linux, when
+// perf_event_open is permitted) hardware cache misses.
+//
+// The bulk algorithms of vector_algorithms.h are compared with the std
+// algorithms over Vector<int32_t> and Vector<float>; --simd restricts the
+// kernels to one instruction set. FlatLookup compares the FlatSet search
+// layouts over sets of ints.
+
+#include "flat_map.h"
+#include "vector.h"
+#include "vector_algorithms.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Heap usage of the timed regions, updated by the global operator new below
+struct AllocationCounters {
+    size_t count = 0;
+    size_t bytes = 0;
+    bool enabled = false;
+};
+
+AllocationCounters allocation_counters;
+
+}  // namespace
+
+// The replacements below pair malloc with free, which GCC cannot see through
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size) {
+    if (allocation_counters.enabled) {
+        ++allocation_counters.count;
+        allocation_counters.bytes += size;
+    }
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+
+// Hardware cache-miss counter; reports nothing where perf events are unavailable
+class CacheMissCounter {
+public:
+    CacheMissCounter() {
+#ifdef __linux__
+        perf_event_attr attr{};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    CacheMissCounter(const CacheMissCounter&) = delete;
+    CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+    ~CacheMissCounter() {
+#ifdef __linux__
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+#endif
+    }
+
+    bool IsAvailable() const noexcept {
+        return fd_ >= 0;
+    }
+
+    void Reset() noexcept {
+#ifdef __linux__
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        }
+#endif
+    }
+
+    void Start() noexcept {
+#ifdef __linux__
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    void Stop() noexcept {
+#ifdef __linux__
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        }
+#endif
+    }
+
+    uint64_t Read() const noexcept {
+        uint64_t value = 0;
+#ifdef __linux__
+        if (fd_ >= 0 && read(fd_, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value))) {
+            value = 0;
+        }
+#endif
+        return value;
+    }
+
+private:
+    int fd_ = -1;
+};
+
+CacheMissCounter& GetCacheMissCounter() {
+    static CacheMissCounter counter;
+    return counter;
+}
+
+template <typename T>
+void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+// Drives the timed loop of one benchmark run, in the spirit of Google Benchmark:
+//     for ([[maybe_unused]] auto _ : state) { ... }
+// Setup that must not be measured goes between PauseTiming() and ResumeTiming().
+class State {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    State(size_t range, size_t iterations)
+        : range_(range)
+        , iterations_(iterations)
+    {
+    }
+
+    class Iterator {
+    public:
+        explicit Iterator(State* state) noexcept
+            : state_(state)
+        {
+        }
+
+        bool operator!=(const Iterator&) const {
+            if (state_->remaining_ == 0) {
+                state_->PauseTiming();
+                return false;
+            }
+            return true;
+        }
+
+        Iterator& operator++() noexcept {
+            --state_->remaining_;
+            return *this;
+        }
+
+        int operator*() const noexcept {
+            return 0;
+        }
+
+    private:
+        State* state_;
+    };
+
+    Iterator begin() {
+        remaining_ = iterations_;
+        ResumeTiming();
+        return Iterator(this);
+    }
+
+    Iterator end() noexcept {
+        return Iterator(this);
+    }
+
+    void PauseTiming() {
+        elapsed_ += Clock::now() - start_;
+        allocation_counters.enabled = false;
+        GetCacheMissCounter().Stop();
+    }
+
+    void ResumeTiming() {
+        GetCacheMissCounter().Start();
+        allocation_counters.enabled = true;
+        start_ = Clock::now();
+    }
+
+    size_t Range() const noexcept {
+        return range_;
+    }
+
+    size_t Iterations() const noexcept {
+        return iterations_;
+    }
+
+    void SetItemsProcessed(size_t items) noexcept {
+        items_processed_ = items;
+    }
+
+    size_t ItemsProcessed() const noexcept {
+        return items_processed_;
+    }
+
+    double ElapsedSeconds() const noexcept {
+        return std::chrono::duration<double>(elapsed_).count();
+    }
+
+private:
+    size_t range_;
+    size_t iterations_;
+    size_t remaining_ = 0;
+    size_t items_processed_ = 0;
+    Clock::time_point start_;
+    Clock::duration elapsed_{};
+};
+
+// Element types
+
+struct Pod64 {
+    uint64_t fields[8];
+};
+
+static_assert(sizeof(Pod64) == 64);
+
+// Move constructor may throw, so containers copy it on reallocation
+struct ThrowingMove {
+    ThrowingMove() = default;
+    ThrowingMove(const ThrowingMove&) = default;
+    ThrowingMove(ThrowingMove&& other)
+        : value(std::move(other.value))
+    {
+    }
+    ThrowingMove& operator=(const ThrowingMove&) = default;
+    ThrowingMove& operator=(ThrowingMove&&) = default;
+
+    std::string value = "a string that does not fit into SSO";
+};
+
+template <typename T>
+T MakeValue();
+
+template <>
+int MakeValue<int>() {
+    return 42;
+}
+
+template <>
+Pod64 MakeValue<Pod64>() {
+    return Pod64{{1, 2, 3, 4, 5, 6, 7, 8}};
+}
+
+template <>
+std::string MakeValue<std::string>() {
+    return "a string that does not fit into SSO";
+}
+
+template <>
+ThrowingMove MakeValue<ThrowingMove>() {
+    return ThrowingMove{};
+}
+
+// Uniform operations over both containers
+
+template <typename T>
+void PushBack(std::vector<T>& v, const T& value) {
+    v.push_back(value);
+}
+
+template <typename T>
+void PushBack(Vector<T>& v, const T& value) {
+    v.PushBack(value);
+}
+
+template <typename T>
+void EmplaceBack(std::vector<T>& v) {
+    v.emplace_back();
+}
+
+template <typename T>
+void EmplaceBack(Vector<T>& v) {
+    v.EmplaceBack();
+}
+
+template <typename T>
+void Reserve(std::vector<T>& v, size_t capacity) {
+    v.reserve(capacity);
+}
+
+template <typename T>
+void Reserve(Vector<T>& v, size_t capacity) {
+    v.Reserve(capacity);
+}
+
+template <typename T>
+void Resize(std::vector<T>& v, size_t size) {
+    v.resize(size);
+}
+
+template <typename T>
+void Resize(Vector<T>& v, size_t size) {
+    v.Resize(size);
+}
+
+template <typename T>
+void InsertAt(std::vector<T>& v, size_t index, const T& value) {
+    v.insert(v.begin() + index, value);
+}
+
+template <typename T>
+void InsertAt(Vector<T>& v, size_t index, const T& value) {
+    v.Insert(v.cbegin() + index, value);
+}
+
+template <typename T>
+void EraseAt(std::vector<T>& v, size_t index) {
+    v.erase(v.begin() + index);
+}
+
+template <typename T>
+void EraseAt(Vector<T>& v, size_t index) {
+    v.Erase(v.cbegin() + index);
+}
+
+template <typename T>
+size_t SizeOf(const std::vector<T>& v) {
+    return v.size();
+}
+
+template <typename T>
+size_t SizeOf(const Vector<T>& v) {
+    return v.Size();
+}
+
+enum class Position {
+    FRONT,
+    MIDDLE,
+    BACK,
+};
+
+size_t IndexOf(Position position, size_t size) {
+    switch (position) {
+        case Position::FRONT:
+            return 0;
+        case Position::MIDDLE:
+            return size / 2;
+        case Position::BACK:
+            return size;
+    }
+    return size;
+}
+
+// Benchmarks
+
+template <typename Container>
+void BM_PushBack(State& state) {
+    using T = typename Container::value_type;
+    const T value = MakeValue<T>();
+    for ([[maybe_unused]] auto _ : state) {
+        Container v;
+        for (size_t i = 0; i < state.Range(); ++i) {
+            PushBack(v, value);
+        }
+        DoNotOptimize(v);
+        state.PauseTiming();
+        v = Container();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.Range());
+}
+
+template <typename Container>
+void BM_EmplaceBack(State& state) {
+    for ([[maybe_unused]] auto _ : state) {
+        Container v;
+        for (size_t i = 0; i < state.Range(); ++i) {
+            EmplaceBack(v);
+        }
+        DoNotOptimize(v);
+        state.PauseTiming();
+        v = Container();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.Range());
+}
+
+// Cost of relocating Range() elements into a buffer twice as large
+template <typename Container>
+void BM_ReserveGrowth(State& state) {
+    using T = typename Container::value_type;
+    for ([[maybe_unused]] auto _ : state) {
+        state.PauseTiming();
+        Container v;
+        Resize(v, state.Range());
+        std::fill(v.begin(), v.end(), MakeValue<T>());
+        state.ResumeTiming();
+        Reserve(v, state.Range() * 2);
+        DoNotOptimize(v);
+        state.PauseTiming();
+        v = Container();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.Range());
+}
+
+template <typename Container, Position Pos>
+void BM_Insert(State& state) {
+    using T = typename Container::value_type;
+    const T value = MakeValue<T>();
+    Container v;
+    Resize(v, state.Range());
+    Reserve(v, state.Range() + 1);
+    const size_t index = IndexOf(Pos, state.Range());
+    for ([[maybe_unused]] auto _ : state) {
+        InsertAt(v, index, value);
+        DoNotOptimize(v);
+        state.PauseTiming();
+        EraseAt(v, index);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(1);
+}
+
+template <typename Container, Position Pos>
+void BM_Erase(State& state) {
+    using T = typename Container::value_type;
+    const T value = MakeValue<T>();
+    Container v;
+    Resize(v, state.Range());
+    const size_t index = std::min(IndexOf(Pos, state.Range()), state.Range() - 1);
+    for ([[maybe_unused]] auto _ : state) {
+        EraseAt(v, index);
+        DoNotOptimize(v);
+        state.PauseTiming();
+        InsertAt(v, index, value);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(1);
+}
+
+template <typename Container>
+void BM_CopyAssign(State& state) {
+    using T = typename Container::value_type;
+    Container src;
+    Resize(src, state.Range());
+    std::fill(src.begin(), src.end(), MakeValue<T>());
+    Container dst;
+    for ([[maybe_unused]] auto _ : state) {
+        dst = src;
+        DoNotOptimize(dst);
+        state.PauseTiming();
+        dst = Container();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.Range());
+}
+
+template <typename Container>
+void BM_Resize(State& state) {
+    for ([[maybe_unused]] auto _ : state) {
+        Container v;
+        Resize(v, state.Range());
+        DoNotOptimize(v);
+        state.PauseTiming();
+        v = Container();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.Range());
+}
+
+// Bulk algorithms, std versions against vector_algorithms.h
+
+enum class Implementation {
+    STD,
+    KERNELS,
+};
+
+template <typename T>
+Vector<T> MakeAlgorithmInput(size_t size) {
+    Vector<T> v(size);
+    for (size_t i = 0; i < size; ++i) {
+        v[i] = static_cast<T>(i % 1000);
+    }
+    return v;
+}
+
+template <typename T, Implementation Impl>
+void BM_Fill(State& state) {
+    Vector<T> v(state.Range());
+    for ([[maybe_unused]] auto _ : state) {
+        if constexpr (Impl == Implementation::STD) {
+            std::fill(v.begin(), v.end(), T(1));
+        } else {
+            Fill(v, T(1));
+        }
+        DoNotOptimize(v);
+    }
+    state.SetItemsProcessed(state.Range());
+}
+
+// The value is absent, so the whole range is scanned
+template <typename T, Implementation Impl>
+void BM_Find(State& state) {
+    const Vector<T> v = MakeAlgorithmInput<T>(state.Range());
+    for ([[maybe_unused]] auto _ : state) {
+        const T* result;
+        if constexpr (Impl == Implementation::STD) {
+            result = std::find(v.begin(), v.end(), T(-1));
+        } else {
+            result = Find(v, T(-1));
+        }
+        DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(state.Range());
+}
+
+template <typename T, Implementation Impl>
+void BM_Count(State& state) {
+    const Vector<T> v = MakeAlgorithmInput<T>(state.Range());
+    for ([[maybe_unused]] auto _ : state) {
+        size_t result;
+        if constexpr (Impl == Implementation::STD) {
+            result = std::count(v.begin(), v.end(), T(7));
+        } else {
+            result = Count(v, T(7));
+        }
+        DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(state.Range());
+}
+
+template <typename T, Implementation Impl>
+void BM_Sum(State& state) {
+    const Vector<T> v = MakeAlgorithmInput<T>(state.Range());
+    for ([[maybe_unused]] auto _ : state) {
+        T result;
+        if constexpr (Impl == Implementation::STD) {
+            result = std::accumulate(v.begin(), v.end(), T{});
+        } else {
+            result = Sum(v);
+        }
+        DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(state.Range());
+}
+
+template <typename T, Implementation Impl>
+void BM_MinMax(State& state) {
+    const Vector<T> v = MakeAlgorithmInput<T>(state.Range());
+    for ([[maybe_unused]] auto _ : state) {
+        std::pair<T, T> result;
+        if constexpr (Impl == Implementation::STD) {
+            const auto [min, max] = std::minmax_element(v.begin(), v.end());
+            result = {*min, *max};
+        } else {
+            result = MinMax(v);
+        }
+        DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(state.Range());
+}
+
+template <typename T, Implementation Impl>
+void BM_Transform(State& state) {
+    const Vector<T> v = MakeAlgorithmInput<T>(state.Range());
+    Vector<T> out(state.Range());
+    const auto op = [](T x) {
+        return x * 3 + 1;
+    };
+    for ([[maybe_unused]] auto _ : state) {
+        if constexpr (Impl == Implementation::STD) {
+            std::transform(v.begin(), v.end(), out.begin(), op);
+        } else {
+            Transform(v, out.begin(), op);
+        }
+        DoNotOptimize(out);
+    }
+    state.SetItemsProcessed(state.Range());
+}
+
+// Looks up every key of a pseudo-random sequence, half of them absent
+template <FlatSearch Search>
+void BM_FlatLookup(State& state) {
+    Vector<int> keys(state.Range());
+    std::iota(keys.begin(), keys.end(), 0);
+    std::for_each(keys.begin(), keys.end(), [](int& key) {
+        key *= 2;
+    });
+    const FlatSet<int, std::less<int>, std::allocator<int>, Search> set(keys.begin(), keys.end());
+    const size_t mask = (size_t{1} << detail::FloorLog2(2 * state.Range())) - 1;
+    for ([[maybe_unused]] auto _ : state) {
+        size_t found = 0;
+        size_t key = 1;
+        for (size_t i = 0; i < state.Range(); ++i) {
+            key = (key * 1103515245 + 12345) & mask;
+            found += set.Contains(static_cast<int>(key));
+        }
+        DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(state.Range());
+}
+
+// Registry and runner
+
+struct BenchmarkCase {
+    std::string name;
+    std::function<void(State&)> function;
+};
+
+template <typename T>
+std::string_view TypeName();
+
+template <>
+std::string_view TypeName<int>() {
+    return "int";
+}
+
+template <>
+std::string_view TypeName<float>() {
+    return "float";
+}
+
+template <>
+std::string_view TypeName<Pod64>() {
+    return "Pod64";
+}
+
+template <>
+std::string_view TypeName<std::string>() {
+    return "string";
+}
+
+template <>
+std::string_view TypeName<ThrowingMove>() {
+    return "ThrowingMove";
+}
+
+template <typename Container>
+void RegisterForContainer(std::vector<BenchmarkCase>& cases, std::string_view container_name) {
+    using T = typename Container::value_type;
+    const std::string suffix = std::string("<") + std::string(container_name) + "<" + std::string(TypeName<T>()) + ">>";
+    cases.push_back({"PushBack" + suffix, BM_PushBack<Container>});
+    cases.push_back({"EmplaceBack" + suffix, BM_EmplaceBack<Container>});
+    cases.push_back({"ReserveGrowth" + suffix, BM_ReserveGrowth<Container>});
+    cases.push_back({"InsertFront" + suffix, BM_Insert<Container, Position::FRONT>});
+    cases.push_back({"InsertMiddle" + suffix, BM_Insert<Container, Position::MIDDLE>});
+    cases.push_back({"InsertBack" + suffix, BM_Insert<Container, Position::BACK>});
+    cases.push_back({"EraseFront" + suffix, BM_Erase<Container, Position::FRONT>});
+    cases.push_back({"EraseMiddle" + suffix, BM_Erase<Container, Position::MIDDLE>});
+    cases.push_back({"EraseBack" + suffix, BM_Erase<Container, Position::BACK>});
+    cases.push_back({"CopyAssign" + suffix, BM_CopyAssign<Container>});
+    cases.push_back({"Resize" + suffix, BM_Resize<Container>});
+}
+
+template <typename T>
+void RegisterForType(std::vector<BenchmarkCase>& cases) {
+    RegisterForContainer<std::vector<T>>(cases, "std::vector");
+    RegisterForContainer<Vector<T>>(cases, "Vector");
+}
+
+template <typename T, Implementation Impl>
+void RegisterAlgorithms(std::vector<BenchmarkCase>& cases, std::string_view implementation_name) {
+    const std::string suffix = std::string("<") + std::string(implementation_name) + "<" + std::string(TypeName<T>()) + ">>";
+    cases.push_back({"Fill" + suffix, BM_Fill<T, Impl>});
+    cases.push_back({"Find" + suffix, BM_Find<T, Impl>});
+    cases.push_back({"Count" + suffix, BM_Count<T, Impl>});
+    cases.push_back({"Sum" + suffix, BM_Sum<T, Impl>});
+    cases.push_back({"MinMax" + suffix, BM_MinMax<T, Impl>});
+    cases.push_back({"Transform" + suffix, BM_Transform<T, Impl>});
+}
+
+std::vector<BenchmarkCase> RegisterBenchmarks() {
+    std::vector<BenchmarkCase> cases;
+    RegisterForType<int>(cases);
+    RegisterForType<Pod64>(cases);
+    RegisterForType<std::string>(cases);
+    RegisterForType<ThrowingMove>(cases);
+    RegisterAlgorithms<int, Implementation::STD>(cases, "std");
+    RegisterAlgorithms<int, Implementation::KERNELS>(cases, "kernels");
+    RegisterAlgorithms<float, Implementation::STD>(cases, "std");
+    RegisterAlgorithms<float, Implementation::KERNELS>(cases, "kernels");
+    cases.push_back({"FlatLookup<binary>", BM_FlatLookup<FlatSearch::BINARY>});
+    cases.push_back({"FlatLookup<branchless>", BM_FlatLookup<FlatSearch::BRANCHLESS>});
+    cases.push_back({"FlatLookup<eytzinger>", BM_FlatLookup<FlatSearch::EYTZINGER>});
+    return cases;
+}
+
+struct Options {
+    std::string filter;
+    size_t max_size = 1 << 20;
+    double min_time = 0.1;
+    bool csv = false;
+};
+
+struct Result {
+    size_t iterations = 0;
+    double seconds = 0;
+    size_t allocations = 0;
+    size_t allocated_bytes = 0;
+    uint64_t cache_misses = 0;
+    size_t items = 0;
+};
+
+// Repeats the benchmark with growing iteration counts until it runs for at
+// least min_time seconds
+Result RunBenchmark(const BenchmarkCase& benchmark, size_t range, double min_time) {
+    size_t iterations = 1;
+    while (true) {
+        State state(range, iterations);
+        allocation_counters = {};
+        GetCacheMissCounter().Reset();
+        benchmark.function(state);
+
+        const double seconds = state.ElapsedSeconds();
+        if (seconds >= min_time || iterations >= 1'000'000'000) {
+            return {iterations, seconds, allocation_counters.count, allocation_counters.bytes,
+                    GetCacheMissCounter().Read(), state.ItemsProcessed()};
+        }
+        const double scale = seconds > 0 ? min_time * 1.4 / seconds : 10.0;
+        iterations = static_cast<size_t>(static_cast<double>(iterations) * std::clamp(scale, 2.0, 10.0));
+    }
+}
+
+void PrintHeader(const Options& options) {
+    if (options.csv) {
+        std::printf("name,size,iterations,ns_per_iter,ns_per_item,allocs_per_iter,bytes_per_iter,cache_misses_per_iter\n");
+    } else {
+        std::printf("%-44s %10s %10s %14s %12s %10s %14s %14s\n", "Benchmark", "Size", "Iters", "ns/iter", "ns/item",
+                    "allocs", "bytes", "cache-misses");
+    }
+}
+
+void PrintResult(const Options& options, const std::string& name, size_t range, const Result& result) {
+    const double iterations = static_cast<double>(result.iterations);
+    const double ns_per_iter = result.seconds * 1e9 / iterations;
+    const double ns_per_item = result.items != 0 ? ns_per_iter / static_cast<double>(result.items) : ns_per_iter;
+    const double allocs = static_cast<double>(result.allocations) / iterations;
+    const double bytes = static_cast<double>(result.allocated_bytes) / iterations;
+    const bool has_misses = GetCacheMissCounter().IsAvailable();
+    const double misses = static_cast<double>(result.cache_misses) / iterations;
+    if (options.csv) {
+        std::printf("%s,%zu,%zu,%.2f,%.3f,%.2f,%.1f,", name.c_str(), range, result.iterations, ns_per_iter,
+                    ns_per_item, allocs, bytes);
+        if (has_misses) {
+            std::printf("%.1f", misses);
+        }
+        std::printf("\n");
+    } else {
+        std::printf("%-44s %10zu %10zu %14.1f %12.3f %10.2f %14.1f ", name.c_str(), range, result.iterations,
+                    ns_per_iter, ns_per_item, allocs, bytes);
+        if (has_misses) {
+            std::printf("%14.1f\n", misses);
+        } else {
+            std::printf("%14s\n", "n/a");
+        }
+    }
+    std::fflush(stdout);
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    using namespace std::literals;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg.substr(0, "--filter="sv.size()) == "--filter="sv) {
+            options.filter = std::string(arg.substr("--filter="sv.size()));
+        } else if (arg.substr(0, "--max-size="sv.size()) == "--max-size="sv) {
+            options.max_size = std::stoull(std::string(arg.substr("--max-size="sv.size())));
+        } else if (arg.substr(0, "--min-time="sv.size()) == "--min-time="sv) {
+            options.min_time = std::stod(std::string(arg.substr("--min-time="sv.size())));
+        } else if (arg == "--csv"sv) {
+            options.csv = true;
+        } else if (arg.substr(0, "--simd="sv.size()) == "--simd="sv) {
+            const std::string_view name = arg.substr("--simd="sv.size());
+            const std::pair<std::string_view, SimdLevel> levels[] = {{"scalar"sv, SimdLevel::SCALAR},
+                                                                     {"sse2"sv, SimdLevel::SSE2},
+                                                                     {"avx2"sv, SimdLevel::AVX2},
+                                                                     {"avx512"sv, SimdLevel::AVX512},
+                                                                     {"neon"sv, SimdLevel::NEON}};
+            const auto level = std::find_if(std::begin(levels), std::end(levels), [name](const auto& entry) {
+                return entry.first == name;
+            });
+            if (level == std::end(levels) || !SetSimdLevel(level->second)) {
+                std::cerr << "Unsupported instruction set "sv << name << std::endl;
+                return false;
+            }
+        } else {
+            std::cerr << "Unknown option "sv << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    using namespace std::literals;
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        std::cerr << "Usage: "sv << argv[0]
+                  << " [--filter=<substring>] [--max-size=<n>] [--min-time=<seconds>] [--csv]"
+                     " [--simd=scalar|sse2|avx2|avx512|neon]"sv << std::endl;
+        return 1;
+    }
+
+    const size_t ranges[] = {8, 64, 512, 4096, 32768, 262144, 2097152, 16777216, 100000000};
+
+    PrintHeader(options);
+    for (const BenchmarkCase& benchmark : RegisterBenchmarks()) {
+        if (benchmark.name.find(options.filter) == std::string::npos) {
+            continue;
+        }
+        for (size_t range : ranges) {
+            if (range > options.max_size) {
+                break;
+            }
+            PrintResult(options, benchmark.name, range, RunBenchmark(benchmark, range, options.min_time));
+        }
+    }
+}
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+// Per-thread cache of recently freed buffers. Buffers are rounded up to
+// power-of-two size classes from 16 bytes to MAX_CACHED_BUFFER_BYTES; each
+// class keeps a free list, and a thread keeps at most its byte limit cached.
+// A buffer may be freed on another thread than the one that allocated it, it
+// then joins the cache of the freeing thread.
+
+struct BufferCacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    // Buffers released to operator delete because the cache was full
+    size_t evictions = 0;
+    size_t cached_buffers = 0;
+    size_t cached_bytes = 0;
+};
+
+namespace detail {
+
+class ThreadBufferCache {
+public:
+    static constexpr size_t MIN_CLASS_LOG2 = 4;
+    static constexpr size_t MAX_CLASS_LOG2 = 20;
+    static constexpr size_t DEFAULT_CAPACITY_BYTES = size_t{4} << 20;
+
+    ~ThreadBufferCache() {
+        Clear();
+        destroyed_ = true;
+    }
+
+    // nullptr once the calling thread's cache has been destroyed
+    static ThreadBufferCache* Instance() noexcept {
+        if (destroyed_) {
+            return nullptr;
+        }
+        thread_local ThreadBufferCache cache;
+        return &cache;
+    }
+
+    // Power-of-two class for a buffer of bytes, or NUM_CLASSES when it is too
+    // large to be cached
+    static size_t ClassOf(size_t bytes) noexcept {
+        size_t class_index = 0;
+        while (class_index < NUM_CLASSES && ClassBytes(class_index) < bytes) {
+            ++class_index;
+        }
+        return class_index;
+    }
+
+    static size_t ClassBytes(size_t class_index) noexcept {
+        return size_t{1} << (class_index + MIN_CLASS_LOG2);
+    }
+
+    void* Allocate(size_t class_index) {
+        if (FreeBlock* block = free_lists_[class_index]) {
+            free_lists_[class_index] = block->next;
+            ++stats_.hits;
+            --stats_.cached_buffers;
+            stats_.cached_bytes -= ClassBytes(class_index);
+            return block;
+        }
+        ++stats_.misses;
+        return operator new(ClassBytes(class_index));
+    }
+
+    void Deallocate(void* p, size_t class_index) noexcept {
+        const size_t bytes = ClassBytes(class_index);
+        if (stats_.cached_bytes + bytes > capacity_bytes_) {
+            ++stats_.evictions;
+            operator delete(p);
+            return;
+        }
+        free_lists_[class_index] = new (p) FreeBlock{free_lists_[class_index]};
+        ++stats_.cached_buffers;
+        stats_.cached_bytes += bytes;
+    }
+
+    void Clear() noexcept {
+        for (FreeBlock*& head : free_lists_) {
+            while (head != nullptr) {
+                FreeBlock* next = head->next;
+                operator delete(head);
+                head = next;
+            }
+        }
+        stats_.cached_buffers = 0;
+        stats_.cached_bytes = 0;
+    }
+
+    void SetCapacity(size_t bytes) noexcept {
+        capacity_bytes_ = bytes;
+        if (stats_.cached_bytes > capacity_bytes_) {
+            Clear();
+        }
+    }
+
+    const BufferCacheStats& GetStats() const noexcept {
+        return stats_;
+    }
+
+    void ResetStats() noexcept {
+        stats_.hits = 0;
+        stats_.misses = 0;
+        stats_.evictions = 0;
+    }
+
+private:
+    static constexpr size_t NUM_CLASSES = MAX_CLASS_LOG2 - MIN_CLASS_LOG2 + 1;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    FreeBlock* free_lists_[NUM_CLASSES] = {};
+    size_t capacity_bytes_ = DEFAULT_CAPACITY_BYTES;
+    BufferCacheStats stats_;
+
+    static inline thread_local bool destroyed_ = false;
+};
+
+}  // namespace detail
+
+inline constexpr size_t MAX_CACHED_BUFFER_BYTES = size_t{1} << detail::ThreadBufferCache::MAX_CLASS_LOG2;
+
+// Statistics of the calling thread's cache
+inline BufferCacheStats GetThreadBufferCacheStats() noexcept {
+    const detail::ThreadBufferCache* cache = detail::ThreadBufferCache::Instance();
+    return cache != nullptr ? cache->GetStats() : BufferCacheStats{};
+}
+
+inline void ResetThreadBufferCacheStats() noexcept {
+    if (detail::ThreadBufferCache* cache = detail::ThreadBufferCache::Instance()) {
+        cache->ResetStats();
+    }
+}
+
+// Returns the calling thread's cached buffers to operator delete
+inline void ClearThreadBufferCache() noexcept {
+    if (detail::ThreadBufferCache* cache = detail::ThreadBufferCache::Instance()) {
+        cache->Clear();
+    }
+}
+
+// Limits the bytes cached by the calling thread (4 MiB by default)
+inline void SetThreadBufferCacheCapacity(size_t bytes) noexcept {
+    if (detail::ThreadBufferCache* cache = detail::ThreadBufferCache::Instance()) {
+        cache->SetCapacity(bytes);
+    }
+}
+
+// Allocator serving RawMemory buffers from the thread-local buffer cache, so
+// short-lived Vectors of similar sizes skip operator new and delete. Buffers
+// larger than MAX_CACHED_BUFFER_BYTES and over-aligned T bypass the cache.
+template <typename T>
+struct CachingAllocator {
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    CachingAllocator() noexcept = default;
+
+    template <typename U>
+    CachingAllocator(const CachingAllocator<U>&) noexcept {
+    }
+
+    T* allocate(size_t n) {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        const size_t class_index = ClassOf(n);
+        if (class_index == NOT_CACHED) {
+            return std::allocator<T>().allocate(n);
+        }
+        if (detail::ThreadBufferCache* cache = detail::ThreadBufferCache::Instance()) {
+            return static_cast<T*>(cache->Allocate(class_index));
+        }
+        // The buffer may still end up in a cache, so it gets its full class size
+        return static_cast<T*>(operator new(detail::ThreadBufferCache::ClassBytes(class_index)));
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        const size_t class_index = ClassOf(n);
+        if (class_index == NOT_CACHED) {
+            std::allocator<T>().deallocate(p, n);
+        } else if (detail::ThreadBufferCache* cache = detail::ThreadBufferCache::Instance()) {
+            cache->Deallocate(p, class_index);
+        } else {
+            operator delete(p);
+        }
+    }
+
+    template <typename U>
+    bool operator==(const CachingAllocator<U>&) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const CachingAllocator<U>&) const noexcept {
+        return false;
+    }
+
+private:
+    static constexpr size_t NOT_CACHED = std::numeric_limits<size_t>::max();
+
+    static size_t ClassOf(size_t n) noexcept {
+        if (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__ || n * sizeof(T) > MAX_CACHED_BUFFER_BYTES) {
+            return NOT_CACHED;
+        }
+        return detail::ThreadBufferCache::ClassOf(n * sizeof(T));
+    }
+};
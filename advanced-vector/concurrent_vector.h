@@ -0,0 +1,192 @@
+#pragma once
+
+#include "vector.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// Append-only vector for many concurrent writers. Elements live in segments
+// of FirstSegmentSize, 2 * FirstSegmentSize, 4 * FirstSegmentSize, ...
+// elements which are never moved, so references stay valid until the vector
+// is destroyed. EmplaceBack reserves its slot with a single atomic increment
+// and only synchronizes with other writers when it is the first to touch a
+// segment. Readers may access any slot whose element has been constructed;
+// IsConstructed() and TryGet() tell whether it has.
+//
+// Only destruction must not race with other operations. Flatten() may run
+// concurrently with appends and ignores slots not constructed yet.
+template <typename T, typename Alloc = std::allocator<T>, size_t FirstSegmentSize = 32>
+class ConcurrentVector {
+public:
+    static_assert(FirstSegmentSize > 0 && (FirstSegmentSize & (FirstSegmentSize - 1)) == 0,
+                  "FirstSegmentSize must be a power of two");
+
+    using value_type = T;
+    using allocator_type = Alloc;
+
+    ConcurrentVector() = default;
+
+    explicit ConcurrentVector(const Alloc& alloc) noexcept
+        : alloc_(alloc)
+    {
+    }
+
+    ConcurrentVector(const ConcurrentVector&) = delete;
+    ConcurrentVector& operator=(const ConcurrentVector&) = delete;
+
+    ~ConcurrentVector() {
+        const size_t size = Size();
+        for (size_t segment = 0; segment < MAX_SEGMENTS; ++segment) {
+            Segment* seg = segments_[segment].load(std::memory_order_acquire);
+            if (seg == nullptr) {
+                continue;
+            }
+            const size_t first = SegmentBegin(segment);
+            const size_t count = std::min(SegmentSize(segment), size > first ? size - first : 0);
+            for (size_t offset = 0; offset < count; ++offset) {
+                if (seg->IsReady(offset)) {
+                    std::destroy_at(seg->elements + offset);
+                }
+            }
+            delete seg;
+        }
+    }
+
+    // Constructs an element in a freshly reserved slot. The element is
+    // visible to readers once this returns. If its constructor throws, the
+    // slot stays empty.
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        const size_t index = size_.fetch_add(1, std::memory_order_relaxed);
+        const auto [segment, offset] = Locate(index);
+        Segment& seg = GetOrCreateSegment(segment);
+        T* elem = new (seg.elements + offset) T(std::forward<Args>(args)...);
+        seg.MarkReady(offset);
+        return *elem;
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    // Number of reserved slots, including ones still being constructed
+    size_t Size() const noexcept {
+        return size_.load(std::memory_order_acquire);
+    }
+
+    bool IsConstructed(size_t index) const noexcept {
+        return TryGet(index) != nullptr;
+    }
+
+    // Element at index, or nullptr if it has not been constructed (yet)
+    const T* TryGet(size_t index) const noexcept {
+        if (index >= Size()) {
+            return nullptr;
+        }
+        const auto [segment, offset] = Locate(index);
+        const Segment* seg = segments_[segment].load(std::memory_order_acquire);
+        if (seg == nullptr || !seg->IsReady(offset)) {
+            return nullptr;
+        }
+        return seg->elements + offset;
+    }
+
+    T* TryGet(size_t index) noexcept {
+        return const_cast<T*>(std::as_const(*this).TryGet(index));
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        const T* elem = TryGet(index);
+        ADVANCED_VECTOR_CHECK(elem != nullptr);
+        return *elem;
+    }
+
+    T& operator[](size_t index) noexcept {
+        return const_cast<T&>(std::as_const(*this)[index]);
+    }
+
+    // Copies the constructed elements, in index order, into one contiguous Vector
+    Vector<T, Alloc> Flatten() const {
+        Vector<T, Alloc> result(alloc_);
+        const size_t size = Size();
+        result.Reserve(size);
+        for (size_t index = 0; index < size; ++index) {
+            if (const T* elem = TryGet(index)) {
+                result.PushBack(*elem);
+            }
+        }
+        return result;
+    }
+
+    Alloc GetAllocator() const noexcept {
+        return alloc_;
+    }
+
+private:
+    static constexpr size_t FIRST_SEGMENT_LOG2 = detail::FloorLog2(FirstSegmentSize);
+    static constexpr size_t MAX_SEGMENTS = sizeof(size_t) * 8 - FIRST_SEGMENT_LOG2;
+    static constexpr size_t BITS_PER_WORD = 64;
+
+    struct Segment {
+        Segment(size_t capacity, const Alloc& alloc)
+            : memory(capacity, alloc)
+            , elements(memory.GetAddress())
+            , ready(new std::atomic<uint64_t>[(capacity + BITS_PER_WORD - 1) / BITS_PER_WORD]())
+        {
+        }
+
+        bool IsReady(size_t offset) const noexcept {
+            const uint64_t bit = uint64_t{1} << (offset % BITS_PER_WORD);
+            return (ready[offset / BITS_PER_WORD].load(std::memory_order_acquire) & bit) != 0;
+        }
+
+        void MarkReady(size_t offset) noexcept {
+            const uint64_t bit = uint64_t{1} << (offset % BITS_PER_WORD);
+            ready[offset / BITS_PER_WORD].fetch_or(bit, std::memory_order_release);
+        }
+
+        RawMemory<T, Alloc> memory;
+        T* elements;
+        std::unique_ptr<std::atomic<uint64_t>[]> ready;
+    };
+
+    Alloc alloc_;
+    std::atomic<size_t> size_{0};
+    std::atomic<Segment*> segments_[MAX_SEGMENTS] = {};
+
+    static size_t SegmentSize(size_t segment) noexcept {
+        return FirstSegmentSize << segment;
+    }
+
+    static size_t SegmentBegin(size_t segment) noexcept {
+        return SegmentSize(segment) - FirstSegmentSize;
+    }
+
+    // Segment k holds indices [FirstSegmentSize * (2^k - 1), FirstSegmentSize * (2^(k+1) - 1))
+    static std::pair<size_t, size_t> Locate(size_t index) noexcept {
+        const size_t biased = index + FirstSegmentSize;
+        const size_t log2 = detail::FloorLog2(biased);
+        return {log2 - FIRST_SEGMENT_LOG2, biased - (size_t{1} << log2)};
+    }
+
+    Segment& GetOrCreateSegment(size_t segment) {
+        Segment* seg = segments_[segment].load(std::memory_order_acquire);
+        if (seg != nullptr) {
+            return *seg;
+        }
+        auto fresh = std::make_unique<Segment>(SegmentSize(segment), alloc_);
+        if (segments_[segment].compare_exchange_strong(seg, fresh.get(), std::memory_order_acq_rel,
+                                                       std::memory_order_acquire)) {
+            return *fresh.release();
+        }
+        // Another writer installed the segment first
+        return *seg;
+    }
+};
@@ -0,0 +1,384 @@
+#pragma once
+
+#include "vector.h"
+
+// DequeVector keeps its elements contiguous in one RawMemory buffer with free
+// slots at both ends, so insertion and erasure at begin() are amortized O(1)
+// like at end(). Iterators are plain pointers, as in Vector. Middle
+// insertions and erasures shift the shorter side. When an end runs out of
+// slots, a buffer that is at most half full is recentered in place;
+// otherwise the elements move to a buffer grown by the growth policy, and
+// the end that ran out receives most of the new room.
+template <typename T, typename Alloc = std::allocator<T>, typename Growth = DoublingGrowth<>>
+class DequeVector {
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+    using allocator_type = Alloc;
+    using growth_policy = Growth;
+
+    DequeVector() = default;
+
+    explicit DequeVector(const Alloc& alloc) noexcept
+        : data_(alloc)
+    {
+    }
+
+    explicit DequeVector(size_t size, const Alloc& alloc = Alloc())
+        : data_(size, alloc)
+    {
+        std::uninitialized_value_construct_n(data_.GetAddress(), size);
+        size_ = size;
+    }
+
+    DequeVector(const DequeVector& other)
+        : data_(other.size_, AllocTraits::select_on_container_copy_construction(other.GetAllocator()))
+    {
+        std::uninitialized_copy_n(other.begin(), other.size_, data_.GetAddress());
+        size_ = other.size_;
+    }
+
+    DequeVector(DequeVector&& other) noexcept
+        : data_(std::move(other.data_))
+        , front_(std::exchange(other.front_, 0))
+        , size_(std::exchange(other.size_, 0))
+    {
+    }
+
+    ~DequeVector() {
+        std::destroy_n(begin(), size_);
+    }
+
+    DequeVector& operator=(const DequeVector& rhs) {
+        if (this != &rhs) {
+            AssignElements(rhs.begin(), rhs.Size());
+        }
+        return *this;
+    }
+
+    DequeVector& operator=(DequeVector&& rhs) noexcept(AllocTraits::propagate_on_container_move_assignment::value
+                                                       || AllocTraits::is_always_equal::value) {
+        if (this == &rhs) {
+            return *this;
+        }
+        if (data_.CanStealFrom(rhs.data_)) {
+            Clear();
+            data_ = std::move(rhs.data_);
+            front_ = std::exchange(rhs.front_, 0);
+            size_ = std::exchange(rhs.size_, 0);
+        } else {
+            AssignElements(std::make_move_iterator(rhs.begin()), rhs.Size());
+        }
+        return *this;
+    }
+
+    iterator begin() noexcept {
+        return data_ + front_;
+    }
+
+    iterator end() noexcept {
+        return begin() + size_;
+    }
+
+    const_iterator begin() const noexcept {
+        return data_ + front_;
+    }
+
+    const_iterator end() const noexcept {
+        return begin() + size_;
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<DequeVector&>(*this)[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        ADVANCED_VECTOR_CHECK(index < Size());
+        return begin()[index];
+    }
+
+    void Swap(DequeVector& other) noexcept {
+        data_.Swap(other.data_);
+        std::swap(front_, other.front_);
+        std::swap(size_, other.size_);
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return data_.Capacity();
+    }
+
+    // Free slots before begin()
+    size_t FrontCapacity() const noexcept {
+        return front_;
+    }
+
+    // Free slots after end()
+    size_t BackCapacity() const noexcept {
+        return Capacity() - front_ - size_;
+    }
+
+    Alloc GetAllocator() const noexcept {
+        return data_.GetAllocator();
+    }
+
+    // Grows the buffer to new_capacity elements; the front slack is kept and
+    // the extra room goes to the back
+    void Reserve(size_t new_capacity) {
+        if (new_capacity > Capacity()) {
+            MoveTo(new_capacity, front_);
+        }
+    }
+
+    // Makes room for count PushFront calls without moving the elements again
+    void ReserveFront(size_t count) {
+        if (count > FrontCapacity()) {
+            MoveTo(std::max(Capacity(), detail::CheckedGrowth(size_ + count, sizeof(T))), count);
+        }
+    }
+
+    // Adds or removes elements at the back; new elements are value-initialized
+    void Resize(size_t new_size) {
+        if (new_size > size_) {
+            if (new_size - size_ > BackCapacity()) {
+                MakeRoom(false, new_size - size_);
+            }
+            std::uninitialized_value_construct_n(end(), new_size - size_);
+        } else {
+            std::destroy_n(begin() + new_size, size_ - new_size);
+        }
+        size_ = new_size;
+    }
+
+    void Clear() noexcept {
+        std::destroy_n(begin(), size_);
+        size_ = 0;
+        front_ = 0;
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        if (BackCapacity() == 0) {
+            // Built before the elements move, since args may refer to them
+            T temp(std::forward<Args>(args)...);
+            MakeRoom(false, 1);
+            new (end()) T(std::move(temp));
+        } else {
+            new (end()) T(std::forward<Args>(args)...);
+        }
+        ++size_;
+        return end()[-1];
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    void PopBack() noexcept {
+        if (size_ > 0) {
+            std::destroy_at(end() - 1);
+            --size_;
+        }
+    }
+
+    template <typename... Args>
+    T& EmplaceFront(Args&&... args) {
+        if (FrontCapacity() == 0) {
+            T temp(std::forward<Args>(args)...);
+            MakeRoom(true, 1);
+            new (data_ + (front_ - 1)) T(std::move(temp));
+        } else {
+            new (data_ + (front_ - 1)) T(std::forward<Args>(args)...);
+        }
+        --front_;
+        ++size_;
+        return *begin();
+    }
+
+    void PushFront(const T& value) {
+        EmplaceFront(value);
+    }
+
+    void PushFront(T&& value) {
+        EmplaceFront(std::move(value));
+    }
+
+    void PopFront() noexcept {
+        if (size_ > 0) {
+            std::destroy_at(begin());
+            ++front_;
+            --size_;
+        }
+    }
+
+    // Shifts the elements before or after pos, whichever are fewer
+    template <typename... Args>
+    iterator Emplace(const_iterator pos, Args&&... args) {
+        ADVANCED_VECTOR_CHECK(begin() <= pos && pos <= end());
+        const size_t index = std::distance(cbegin(), pos);
+        if (index == size_) {
+            EmplaceBack(std::forward<Args>(args)...);
+            return end() - 1;
+        }
+        if (index == 0) {
+            EmplaceFront(std::forward<Args>(args)...);
+            return begin();
+        }
+
+        T temp(std::forward<Args>(args)...);
+        if (index < size_ / 2) {
+            if (FrontCapacity() == 0) {
+                MakeRoom(true, 1);
+            }
+            EmplaceShiftingFront(index, std::move(temp));
+        } else {
+            if (BackCapacity() == 0) {
+                MakeRoom(false, 1);
+            }
+            detail::EmplaceShifting(begin(), size_, index, std::move(temp));
+            ++size_;
+        }
+        return begin() + index;
+    }
+
+    iterator Insert(const_iterator pos, const T& value) {
+        return Emplace(pos, value);
+    }
+
+    iterator Insert(const_iterator pos, T&& value) {
+        return Emplace(pos, std::move(value));
+    }
+
+    iterator Erase(const_iterator pos) {
+        ADVANCED_VECTOR_CHECK(begin() <= pos && pos < end());
+        return Erase(pos, pos + 1);
+    }
+
+    // Shifts the elements before or after [first, last), whichever are fewer
+    iterator Erase(const_iterator first, const_iterator last) {
+        ADVANCED_VECTOR_CHECK(begin() <= first && first <= last && last <= end());
+        const size_t index = std::distance(cbegin(), first);
+        const size_t count = std::distance(first, last);
+        if (index < size_ - index - count) {
+            T* data = begin();
+            if constexpr (is_trivially_relocatable_v<T>) {
+                std::destroy_n(data + index, count);
+                if (index != 0) {
+                    std::memmove(static_cast<void*>(data + count), static_cast<const void*>(data), index * sizeof(T));
+                }
+            } else {
+                std::move_backward(data, data + index, data + index + count);
+                std::destroy_n(data, count);
+            }
+            front_ += count;
+        } else {
+            detail::EraseRangeShifting(begin(), size_, index, count);
+        }
+        size_ -= count;
+        return begin() + index;
+    }
+
+private:
+    using Memory = RawMemory<T, Alloc>;
+    using AllocTraits = typename Memory::AllocTraits;
+
+    Memory data_;
+    size_t front_ = 0;
+    size_t size_ = 0;
+
+    // Makes room for count elements at one end. Elements are left intact if
+    // an exception is thrown.
+    void MakeRoom(bool at_front, size_t count) {
+        const size_t required = detail::CheckedGrowth(size_ + count, sizeof(T));
+        if (size_ == 0 && required <= Capacity()) {
+            front_ = at_front ? Capacity() : 0;
+            return;
+        }
+        const size_t new_capacity =
+            required <= Capacity() / 2 ? Capacity() : Growth::NextCapacity(Capacity(), required, sizeof(T));
+        // The other end keeps its slack, up to half of the free slots
+        const size_t free_slots = new_capacity - required;
+        const size_t other_slack = std::min(at_front ? BackCapacity() : FrontCapacity(), free_slots / 2);
+        MoveTo(new_capacity, at_front ? count + free_slots - other_slack : other_slack);
+    }
+
+    // Places the elements at offset new_front of a buffer of new_capacity
+    // elements, reusing the current buffer when it is empty or trivially
+    // relocatable elements can simply be memmoved within it
+    void MoveTo(size_t new_capacity, size_t new_front) {
+        assert(new_front + size_ <= new_capacity);
+        if ((is_trivially_relocatable_v<T> || size_ == 0) && new_capacity == Capacity()) {
+            if (size_ != 0) {
+                std::memmove(static_cast<void*>(data_ + new_front), static_cast<const void*>(begin()),
+                             size_ * sizeof(T));
+            }
+        } else {
+            Memory new_data(new_capacity, data_.GetAllocator());
+            detail::RelocateN(begin(), size_, new_data + new_front);
+            data_.Swap(new_data);
+        }
+        front_ = new_front;
+    }
+
+    // Inserts value at position index by moving the first index elements one
+    // slot towards the front, which must have a free slot
+    void EmplaceShiftingFront(size_t index, T&& value) {
+        assert(front_ > 0 && index > 0);
+        T* first = begin();
+        if constexpr (is_trivially_relocatable_v<T>) {
+            const size_t head_bytes = index * sizeof(T);
+            std::memmove(static_cast<void*>(first - 1), static_cast<const void*>(first), head_bytes);
+            try {
+                new (first + index - 1) T(std::move(value));
+            } catch (...) {
+                std::memmove(static_cast<void*>(first), static_cast<const void*>(first - 1), head_bytes);
+                throw;
+            }
+        } else {
+            new (first - 1) T(std::move(*first));
+            std::move(first + 1, first + index, first);
+            first[index - 1] = std::move(value);
+        }
+        --front_;
+        ++size_;
+    }
+
+    template <typename ForwardIt>
+    void AssignElements(ForwardIt src, size_t n) {
+        if (n > Capacity()) {
+            Memory new_data(n, data_.GetAllocator());
+            std::uninitialized_copy_n(src, n, new_data.GetAddress());
+            Clear();
+            data_.Swap(new_data);
+        } else if (n > Capacity() - front_) {
+            Clear();
+            std::uninitialized_copy_n(src, n, data_.GetAddress());
+        } else {
+            size_t min_size = std::min(n, Size());
+            std::copy_n(src, min_size, begin());
+            std::advance(src, min_size);
+            if (n == min_size) {
+                std::destroy_n(begin() + n, Size() - n);
+            } else {
+                std::uninitialized_copy_n(src, n - Size(), end());
+            }
+        }
+        size_ = n;
+    }
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+// Execution policies run Vector's bulk element operations (construction,
+// copies, relocation and destruction) over index ranges [0, n). Each policy
+// provides
+//     static void Transact(size_t n, Op op, Undo undo);
+//         Calls op(first, last) on subranges covering [0, n). op must leave
+//         its subrange untouched when it throws; undo(first, last) is then
+//         called for every subrange op completed, and the exception is
+//         rethrown.
+//     static void ForEach(size_t n, Op op) noexcept;
+//         Same for operations that never throw.
+
+struct SequentialExecution {
+    template <typename Op, typename Undo>
+    static void Transact(size_t n, Op&& op, Undo&&) {
+        op(size_t{0}, n);
+    }
+
+    template <typename Op>
+    static void ForEach(size_t n, Op&& op) noexcept {
+        op(size_t{0}, n);
+    }
+};
+
+// Splits operations on at least MinParallelSize elements into NumThreads
+// chunks (one per hardware thread when NumThreads is 0), each chunk holding
+// at least MinParallelSize / 2 elements. The calling thread processes a chunk
+// too; if threads cannot be started it processes the remaining chunks itself.
+template <size_t MinParallelSize = (size_t{1} << 20), size_t NumThreads = 0>
+struct ParallelExecution {
+    static_assert(MinParallelSize >= 2, "Chunks need at least one element");
+
+    template <typename Op, typename Undo>
+    static void Transact(size_t n, Op&& op, Undo&& undo) {
+        const size_t num_chunks = ChunkCount(n);
+        if (num_chunks <= 1) {
+            op(size_t{0}, n);
+            return;
+        }
+        std::vector<std::exception_ptr> errors(num_chunks);
+        RunChunks(n, num_chunks, [&](size_t chunk, size_t first, size_t last) noexcept {
+            try {
+                op(first, last);
+            } catch (...) {
+                errors[chunk] = std::current_exception();
+            }
+        });
+        const auto failed = std::find_if(errors.begin(), errors.end(), [](const std::exception_ptr& error) {
+            return error != nullptr;
+        });
+        if (failed == errors.end()) {
+            return;
+        }
+        for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+            if (errors[chunk] == nullptr) {
+                undo(ChunkBegin(n, num_chunks, chunk), ChunkBegin(n, num_chunks, chunk + 1));
+            }
+        }
+        std::rethrow_exception(*failed);
+    }
+
+    template <typename Op>
+    static void ForEach(size_t n, Op&& op) noexcept {
+        const size_t num_chunks = ChunkCount(n);
+        if (num_chunks <= 1) {
+            op(size_t{0}, n);
+            return;
+        }
+        RunChunks(n, num_chunks, [&](size_t, size_t first, size_t last) noexcept {
+            op(first, last);
+        });
+    }
+
+private:
+    static size_t ChunkCount(size_t n) noexcept {
+        if (n < MinParallelSize) {
+            return 1;
+        }
+        const size_t threads = NumThreads != 0 ? NumThreads : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        return std::min(threads, n / (MinParallelSize / 2));
+    }
+
+    static size_t ChunkBegin(size_t n, size_t num_chunks, size_t chunk) noexcept {
+        const size_t chunk_size = (n + num_chunks - 1) / num_chunks;
+        return std::min(n, chunk * chunk_size);
+    }
+
+    // Calls run(chunk, first, last) for every chunk and waits for all of them
+    template <typename Run>
+    static void RunChunks(size_t n, size_t num_chunks, Run run) noexcept {
+        const auto run_chunk = [&](size_t chunk) noexcept {
+            run(chunk, ChunkBegin(n, num_chunks, chunk), ChunkBegin(n, num_chunks, chunk + 1));
+        };
+        std::vector<std::thread> threads;
+        size_t started = 1;
+        try {
+            threads.reserve(num_chunks - 1);
+            for (; started < num_chunks; ++started) {
+                threads.emplace_back(run_chunk, started);
+            }
+        } catch (...) {
+            // Out of threads or memory: the chunks not handed out run below
+        }
+        run_chunk(0);
+        for (size_t chunk = started; chunk < num_chunks; ++chunk) {
+            run_chunk(chunk);
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+};
@@ -0,0 +1,392 @@
+#pragma once
+
+#include "vector.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Lookup strategy of FlatMap and FlatSet
+enum class FlatSearch {
+    // std::lower_bound over the sorted elements
+    BINARY,
+    // Binary search without data-dependent branches; the compiler turns the
+    // comparison into a conditional move, so lookups do not pay for
+    // mispredicted jumps
+    BRANCHLESS,
+    // An extra copy of the keys in breadth-first (Eytzinger) order, where the
+    // top levels of the search share a few cache lines. It is rebuilt after
+    // every modification and suits tables read far more often than written.
+    EYTZINGER,
+};
+
+namespace detail {
+
+struct SetKeyOf {
+    template <typename T>
+    const T& operator()(const T& value) const noexcept {
+        return value;
+    }
+};
+
+struct MapKeyOf {
+    template <typename Pair>
+    const typename Pair::first_type& operator()(const Pair& value) const noexcept {
+        return value.first;
+    }
+};
+
+struct NoSearchIndex {
+    void Clear() noexcept {
+    }
+};
+
+// Unique elements kept sorted by key in a Vector. Single insertions and
+// erasures shift the tail; range insertion appends the new elements, sorts
+// them and merges them with the old ones in one pass. If sorting a batch or
+// rebuilding the Eytzinger index throws, the container is left empty.
+template <typename Value, typename Key, typename KeyOf, typename Compare, typename Alloc, FlatSearch Search>
+class FlatTree {
+    static constexpr bool IS_SET = std::is_same_v<KeyOf, SetKeyOf>;
+
+public:
+    using key_type = Key;
+    using value_type = Value;
+    using key_compare = Compare;
+    using allocator_type = Alloc;
+    // Keys must not be modified through iterators
+    using iterator = std::conditional_t<IS_SET, const Value*, Value*>;
+    using const_iterator = const Value*;
+
+    FlatTree() = default;
+
+    explicit FlatTree(const Compare& comp, const Alloc& alloc = Alloc())
+        : values_(alloc)
+        , comp_(comp)
+    {
+    }
+
+    template <typename InputIt, typename = RequireInputIterator<InputIt>>
+    FlatTree(InputIt first, InputIt last, const Compare& comp = Compare(), const Alloc& alloc = Alloc())
+        : values_(alloc)
+        , comp_(comp)
+    {
+        Insert(first, last);
+    }
+
+    iterator begin() noexcept {
+        return values_.Data();
+    }
+
+    iterator end() noexcept {
+        return values_.Data() + values_.Size();
+    }
+
+    const_iterator begin() const noexcept {
+        return values_.Data();
+    }
+
+    const_iterator end() const noexcept {
+        return values_.Data() + values_.Size();
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    size_t Size() const noexcept {
+        return values_.Size();
+    }
+
+    size_t Capacity() const noexcept {
+        return values_.Capacity();
+    }
+
+    void Reserve(size_t new_capacity) {
+        values_.Reserve(new_capacity);
+    }
+
+    void Clear() noexcept {
+        values_.Clear();
+        index_.Clear();
+    }
+
+    // The sorted elements, e.g. to pass them to the bulk algorithms
+    const Vector<Value, Alloc>& Values() const noexcept {
+        return values_;
+    }
+
+    // First element whose key is not less than key
+    const_iterator LowerBound(const Key& key) const {
+        return begin() + LowerBoundIndex(key);
+    }
+
+    iterator LowerBound(const Key& key) {
+        return begin() + LowerBoundIndex(key);
+    }
+
+    const_iterator Find(const Key& key) const {
+        return begin() + FindIndex(key);
+    }
+
+    iterator Find(const Key& key) {
+        return begin() + FindIndex(key);
+    }
+
+    bool Contains(const Key& key) const {
+        return FindIndex(key) != Size();
+    }
+
+    // Returns the element with the key of value and whether value was
+    // inserted
+    std::pair<iterator, bool> Insert(const Value& value) {
+        return InsertUnique(value);
+    }
+
+    std::pair<iterator, bool> Insert(Value&& value) {
+        return InsertUnique(std::move(value));
+    }
+
+    // Inserts a batch with a single sort and merge instead of one shift per
+    // element. Keys already present, and repeated keys within the batch
+    // after their first occurrence, are skipped.
+    template <typename InputIt, typename = RequireInputIterator<InputIt>>
+    void Insert(InputIt first, InputIt last) {
+        const size_t old_size = Size();
+        try {
+            values_.Append(first, last);
+        } catch (...) {
+            // An input that fails partway leaves its first elements behind,
+            // unsorted and possibly repeating existing keys
+            values_.Erase(values_.cbegin() + old_size, values_.cend());
+            throw;
+        }
+        if (Size() == old_size) {
+            return;
+        }
+        try {
+            const auto value_less = [this](const Value& lhs, const Value& rhs) {
+                return comp_(KeyOf()(lhs), KeyOf()(rhs));
+            };
+            Value* const data = values_.Data();
+            Value* const mid = data + old_size;
+            Value* const last = data + Size();
+            std::stable_sort(mid, last, value_less);
+            // Batches sorted after the existing keys, e.g. appended
+            // timestamps, need neither the merge nor a full unique pass
+            size_t unique_from = old_size == 0 ? 0 : old_size - 1;
+            if (old_size != 0 && !value_less(mid[-1], *mid)) {
+                std::inplace_merge(data, mid, last, value_less);
+                unique_from = 0;
+            }
+            const Value* new_end = std::unique(data + unique_from, last, [this](const Value& lhs, const Value& rhs) {
+                return !comp_(KeyOf()(lhs), KeyOf()(rhs));
+            });
+            values_.Erase(values_.cbegin() + (new_end - data), values_.cend());
+        } catch (...) {
+            Clear();
+            throw;
+        }
+        RebuildIndex();
+    }
+
+    // Returns the number of erased elements, 0 or 1
+    size_t Erase(const Key& key) {
+        const size_t index = FindIndex(key);
+        if (index == Size()) {
+            return 0;
+        }
+        values_.Erase(values_.begin() + index);
+        RebuildIndex();
+        return 1;
+    }
+
+    iterator Erase(const_iterator pos) {
+        return Erase(pos, pos + 1);
+    }
+
+    iterator Erase(const_iterator first, const_iterator last) {
+        const size_t index = first - begin();
+        values_.Erase(values_.cbegin() + index, values_.cbegin() + (last - begin()));
+        RebuildIndex();
+        return begin() + index;
+    }
+
+    // Removes every element satisfying pred in one pass and returns the
+    // number of removed elements
+    template <typename Predicate>
+    size_t EraseIf(Predicate pred) {
+        const size_t num_erased = values_.EraseIf(pred);
+        RebuildIndex();
+        return num_erased;
+    }
+
+    // Removes the elements with any of the keys in [first, last) in one pass
+    // and returns the number of removed elements
+    template <typename InputIt, typename = RequireInputIterator<InputIt>>
+    size_t EraseKeys(InputIt first, InputIt last) {
+        Vector<Key> keys(first, last);
+        std::sort(keys.begin(), keys.end(), comp_);
+        return EraseIf([this, &keys](const Value& value) {
+            return std::binary_search(keys.begin(), keys.end(), KeyOf()(value), comp_);
+        });
+    }
+
+protected:
+    using Index = std::conditional_t<Search == FlatSearch::EYTZINGER,
+                                     Vector<std::pair<Key, size_t>, typename std::allocator_traits<Alloc>::template
+                                                                    rebind_alloc<std::pair<Key, size_t>>>,
+                                     NoSearchIndex>;
+
+    Vector<Value, Alloc> values_;
+    Compare comp_;
+    Index index_;
+
+    size_t LowerBoundIndex(const Key& key) const {
+        const Value* data = values_.Data();
+        if constexpr (Search == FlatSearch::BINARY) {
+            return std::lower_bound(data, data + Size(), key,
+                                    [this](const Value& value, const Key& k) {
+                                        return comp_(KeyOf()(value), k);
+                                    })
+                   - data;
+        } else if constexpr (Search == FlatSearch::BRANCHLESS) {
+            // The lower bound stays within [first, first + len]
+            size_t first = 0;
+            size_t len = Size();
+            while (len > 1) {
+                const size_t half = len / 2;
+                first += comp_(KeyOf()(data[first + half - 1]), key) ? half : 0;
+                len -= half;
+            }
+            return first + (len == 1 && comp_(KeyOf()(data[first]), key));
+        } else {
+            const std::pair<Key, size_t>* node = LowerBoundNode(key);
+            return node == nullptr ? Size() : node->second;
+        }
+    }
+
+    size_t FindIndex(const Key& key) const {
+        if constexpr (Search == FlatSearch::EYTZINGER) {
+            // Compares against the index node, which the search just
+            // visited, rather than touching the element
+            const std::pair<Key, size_t>* node = LowerBoundNode(key);
+            return node != nullptr && !comp_(key, node->first) ? node->second : Size();
+        } else {
+            const size_t index = LowerBoundIndex(key);
+            return index != Size() && !comp_(key, KeyOf()(values_[index])) ? index : Size();
+        }
+    }
+
+    // Eytzinger node holding the lower bound of key, or nullptr if every key
+    // is less
+    const std::pair<Key, size_t>* LowerBoundNode(const Key& key) const {
+        // Node k has children 2k + 1 and 2k + 2. The lower bound is the last
+        // node where the search turned left; in 1-based numbering the path is
+        // the bits of the final node, so shifting out the trailing right turns
+        // and that one left turn recovers it.
+        const std::pair<Key, size_t>* nodes = index_.Data();
+        const size_t n = index_.Size();
+        size_t k = 0;
+        while (k < n) {
+#if defined(__GNUC__)
+            // Descendants four levels down are contiguous, so fetching them
+            // early hides most of the memory latency on big tables. Only
+            // nodes inside the index are addressed.
+            if (16 * k + 15 < n) {
+                __builtin_prefetch(nodes + 16 * k + 15);
+            }
+#endif
+            k = 2 * k + 1 + comp_(nodes[k].first, key);
+        }
+        size_t node = k + 1;
+#if defined(__GNUC__)
+        node >>= __builtin_ctzll(~static_cast<unsigned long long>(node)) + 1;
+#else
+        while (node & 1) {
+            node >>= 1;
+        }
+        node >>= 1;
+#endif
+        return node == 0 ? nullptr : nodes + (node - 1);
+    }
+
+    template <typename V>
+    std::pair<iterator, bool> InsertUnique(V&& value) {
+        const size_t index = LowerBoundIndex(KeyOf()(value));
+        if (index != Size() && !comp_(KeyOf()(value), KeyOf()(values_[index]))) {
+            return {begin() + index, false};
+        }
+        values_.Emplace(values_.begin() + index, std::forward<V>(value));
+        RebuildIndex();
+        return {begin() + index, true};
+    }
+
+    void RebuildIndex() {
+        if constexpr (Search == FlatSearch::EYTZINGER) {
+            try {
+                Vector<size_t> order(Size());
+                FillEytzingerOrder(order, 0, 0);
+                index_.Clear();
+                index_.Reserve(Size());
+                for (const size_t sorted_index : order) {
+                    index_.EmplaceBack(KeyOf()(values_[sorted_index]), sorted_index);
+                }
+            } catch (...) {
+                Clear();
+                throw;
+            }
+        }
+    }
+
+    // Visits the tree in order, numbering node k and its subtrees with the
+    // sorted indices from next on
+    static size_t FillEytzingerOrder(Vector<size_t>& order, size_t next, size_t k) {
+        if (k < order.Size()) {
+            next = FillEytzingerOrder(order, next, 2 * k + 1);
+            order[k] = next++;
+            next = FillEytzingerOrder(order, next, 2 * k + 2);
+        }
+        return next;
+    }
+};
+
+}  // namespace detail
+
+// Sorted-vector set: contiguous elements for cache-friendly lookups and
+// iteration, O(n) single insertions and erasures
+template <typename Key, typename Compare = std::less<Key>, typename Alloc = std::allocator<Key>,
+          FlatSearch Search = FlatSearch::BINARY>
+using FlatSet = detail::FlatTree<Key, Key, detail::SetKeyOf, Compare, Alloc, Search>;
+
+// Sorted-vector map of std::pair<Key, T> elements
+template <typename Key, typename T, typename Compare = std::less<Key>,
+          typename Alloc = std::allocator<std::pair<Key, T>>, FlatSearch Search = FlatSearch::BINARY>
+class FlatMap : public detail::FlatTree<std::pair<Key, T>, Key, detail::MapKeyOf, Compare, Alloc, Search> {
+    using Base = detail::FlatTree<std::pair<Key, T>, Key, detail::MapKeyOf, Compare, Alloc, Search>;
+
+public:
+    using mapped_type = T;
+
+    using Base::Base;
+
+    // Value-initializes the mapped value of a missing key
+    T& operator[](const Key& key) {
+        const size_t index = this->LowerBoundIndex(key);
+        if (index == this->Size() || this->comp_(key, this->values_[index].first)) {
+            this->values_.Emplace(this->values_.begin() + index, std::piecewise_construct, std::forward_as_tuple(key),
+                                  std::forward_as_tuple());
+            this->RebuildIndex();
+        }
+        return this->values_[index].second;
+    }
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <new>
+
+// Growth policies decide how much capacity Vector requests when it runs out of
+// room. Each policy provides
+//     static size_t NextCapacity(size_t capacity, size_t required, size_t element_size);
+// returning a capacity of at least `required` elements. A policy may also
+// provide
+//     static size_t ShrinkCapacity(size_t capacity, size_t size, size_t element_size);
+// which Vector calls after removing elements; a result below `capacity`
+// shrinks the buffer to that many elements (but never below `size`).
+
+namespace detail {
+
+inline size_t MaxElementCount(size_t element_size) noexcept {
+    return static_cast<size_t>(std::numeric_limits<std::ptrdiff_t>::max()) / element_size;
+}
+
+inline size_t CheckedGrowth(size_t required, size_t element_size) {
+    if (required > MaxElementCount(element_size)) {
+        throw std::bad_array_new_length();
+    }
+    return required;
+}
+
+// Multiplies capacity by Num / Den, saturating at the largest possible size
+template <size_t Num, size_t Den, size_t MinCapacity>
+size_t GeometricCapacity(size_t capacity, size_t required, size_t element_size) {
+    CheckedGrowth(required, element_size);
+    const size_t max_count = MaxElementCount(element_size);
+    const size_t grown = capacity > max_count / Num * Den ? max_count : capacity / Den * Num + capacity % Den * Num / Den;
+    return std::max({grown, required, MinCapacity});
+}
+
+}  // namespace detail
+
+// Capacity doubles on each reallocation
+template <size_t MinCapacity = 1>
+struct DoublingGrowth {
+    static size_t NextCapacity(size_t capacity, size_t required, size_t element_size) {
+        return detail::GeometricCapacity<2, 1, MinCapacity>(capacity, required, element_size);
+    }
+};
+
+// Capacity grows by half on each reallocation: at most 1.5x memory overhead,
+// and freed blocks can eventually be reused by later growth steps
+template <size_t MinCapacity = 4>
+struct OneAndHalfGrowth {
+    static size_t NextCapacity(size_t capacity, size_t required, size_t element_size) {
+        return detail::GeometricCapacity<3, 2, MinCapacity>(capacity, required, element_size);
+    }
+};
+
+// Rounds the capacity chosen by Base up to the size class the allocator
+// would hand out anyway. Like jemalloc and tcmalloc, four classes per power of
+// two are assumed; blocks of a page or more are rounded to whole pages.
+template <typename Base = DoublingGrowth<>, size_t PageSize = 4096>
+struct SizeClassGrowth {
+    static size_t NextCapacity(size_t capacity, size_t required, size_t element_size) {
+        const size_t count = Base::NextCapacity(capacity, required, element_size);
+        const size_t bytes = RoundToSizeClass(count * element_size);
+        return std::clamp(bytes / element_size, count, detail::MaxElementCount(element_size));
+    }
+
+    static size_t RoundToSizeClass(size_t bytes) noexcept {
+        if (bytes <= 16) {
+            return 16;
+        }
+        size_t top = 1;
+        while (top <= bytes / 2) {
+            top <<= 1;
+        }
+        size_t step = std::max<size_t>(top / 4, 16);
+        if (bytes >= PageSize) {
+            step = std::max(step, PageSize);
+        }
+        if (bytes > std::numeric_limits<size_t>::max() - step) {
+            return bytes;
+        }
+        return (bytes + step - 1) / step * step;
+    }
+};
+
+// Grows like Base until the buffer reaches LinearStepBytes, then adds at most
+// LinearStepBytes per reallocation so multi-GB vectors do not double their footprint
+template <size_t LinearStepBytes = size_t{1} << 30, typename Base = DoublingGrowth<>>
+struct CappedGrowth {
+    static size_t NextCapacity(size_t capacity, size_t required, size_t element_size) {
+        const size_t step = std::max<size_t>(LinearStepBytes / element_size, 1);
+        if (capacity < step) {
+            return std::max(std::min(Base::NextCapacity(capacity, required, element_size), step), required);
+        }
+        const size_t linear = capacity > detail::MaxElementCount(element_size) - step
+            ? detail::MaxElementCount(element_size)
+            : capacity + step;
+        return std::max(linear, detail::CheckedGrowth(required, element_size));
+    }
+};
+
+// Grows like Base and gives memory back once the size drops below
+// capacity / ShrinkDivisor. The buffer then shrinks to twice the size, so a
+// vector oscillating around one size does not reallocate on every step.
+template <typename Base = DoublingGrowth<>, size_t ShrinkDivisor = 4>
+struct ShrinkingGrowth {
+    static_assert(ShrinkDivisor > 2, "Shrinking to twice the size needs hysteresis above 2");
+
+    static size_t NextCapacity(size_t capacity, size_t required, size_t element_size) {
+        return Base::NextCapacity(capacity, required, element_size);
+    }
+
+    static size_t ShrinkCapacity(size_t capacity, size_t size, size_t) noexcept {
+        return size < capacity / ShrinkDivisor ? size * 2 : capacity;
+    }
+};
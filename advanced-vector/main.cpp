@@ -1,11 +1,47 @@
+#include "aligned_allocator.h"
+#include "arena_allocator.h"
+#include "caching_allocator.h"
+#include "concurrent_vector.h"
+#include "deque_vector.h"
+#include "flat_map.h"
+#include "malloc_allocator.h"
+#include "persistent_vector.h"
+#include "segmented_vector.h"
+#include "small_vector.h"
+#include "soa_vector.h"
+#include "static_vector.h"
 #include "vector.h"
+#include "vector_algorithms.h"
+#include "vector_checks.h"
+#include "vector_io.h"
+#include "virtual_memory_allocator.h"
 
 #include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
 #include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#if ADVANCED_VECTOR_ANNOTATE_CONTAINERS
+#include <sanitizer/asan_interface.h>
+#endif
+#if defined(__unix__)
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 namespace {
 
 inline const uint32_t DEFAULT_COOKIE = 0xdeadbeef;
@@ -116,8 +152,90 @@ struct Obj {
     static inline int num_move_assigned = 0;
 };
 
+template <typename T, bool Propagate>
+struct TrackingAllocator {
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::bool_constant<Propagate>;
+    using propagate_on_container_move_assignment = std::bool_constant<Propagate>;
+    using propagate_on_container_swap = std::bool_constant<Propagate>;
+
+    explicit TrackingAllocator(int id = 0) noexcept
+        : id(id)
+    {
+    }
+
+    template <typename U>
+    TrackingAllocator(const TrackingAllocator<U, Propagate>& other) noexcept
+        : id(other.id)
+    {
+    }
+
+    T* allocate(size_t n) {
+        ++num_allocations;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        ++num_deallocations;
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    bool operator==(const TrackingAllocator& other) const noexcept {
+        return id == other.id;
+    }
+
+    bool operator!=(const TrackingAllocator& other) const noexcept {
+        return id != other.id;
+    }
+
+    static void ResetCounters() {
+        num_allocations = 0;
+        num_deallocations = 0;
+    }
+
+    int id = 0;
+
+    static inline int num_allocations = 0;
+    static inline int num_deallocations = 0;
+};
+
 }
 
+struct RelocatableObj {
+    RelocatableObj() = default;
+
+    explicit RelocatableObj(int id)
+        : value(std::make_unique<int>(id))
+    {
+    }
+
+    RelocatableObj(RelocatableObj&& other) noexcept
+        : value(std::move(other.value))
+    {
+        ++num_moved;
+    }
+
+    RelocatableObj& operator=(RelocatableObj&& other) = default;
+
+    ~RelocatableObj() {
+        ++num_destroyed;
+    }
+
+    static void ResetCounters() {
+        num_moved = 0;
+        num_destroyed = 0;
+    }
+
+    std::unique_ptr<int> value;
+
+    static inline int num_moved = 0;
+    static inline int num_destroyed = 0;
+};
+
+template <>
+struct is_trivially_relocatable<RelocatableObj> : std::true_type {
+};
+
 void Test1() {
     Obj::ResetCounters();
     const size_t SIZE = 100500;
@@ -423,7 +541,7 @@ void Test6() {
     {
         Obj::ResetCounters();
         Vector<Obj> v;
-        auto* pos = v.Emplace(v.end(), Obj{1});
+        auto pos = v.Emplace(v.end(), Obj{1});
         assert(v.Size() == 1);
         assert(v.Capacity() >= v.Size());
         assert(&*pos == &v[0]);
@@ -438,7 +556,7 @@ void Test6() {
         Obj::ResetCounters();
         Vector<Obj> v;
         v.Reserve(SIZE);
-        auto* pos = v.Emplace(v.end(), Obj{1});
+        auto pos = v.Emplace(v.end(), Obj{1});
         assert(v.Size() == 1);
         assert(v.Capacity() >= v.Size());
         assert(&*pos == &v[0]);
@@ -485,7 +603,7 @@ void Test6() {
     {
         Obj::ResetCounters();
         Vector<Obj> v{SIZE};
-        auto* pos = v.Emplace(v.cbegin() + 1, ID, "Ivan"s);
+        auto pos = v.Emplace(v.cbegin() + 1, ID, "Ivan"s);
         assert(v.Size() == SIZE + 1);
         assert(v.Capacity() == SIZE * 2);
         assert(&*pos == &v[1]);
@@ -501,7 +619,7 @@ void Test6() {
     {
         Obj::ResetCounters();
         Vector<Obj> v{SIZE};
-        auto* pos = v.Emplace(v.cbegin() + v.Size(), ID, "Ivan"s);
+        auto pos = v.Emplace(v.cbegin() + v.Size(), ID, "Ivan"s);
         assert(v.Size() == SIZE + 1);
         assert(v.Capacity() == SIZE * 2);
         assert(&*pos == &v[SIZE]);
@@ -520,7 +638,7 @@ void Test6() {
         v.Reserve(SIZE * 2);
         const int old_num_moved = Obj::num_moved;
         assert(v.Capacity() == SIZE * 2);
-        auto* pos = v.Emplace(v.cbegin() + 3, ID, "Ivan"s);
+        auto pos = v.Emplace(v.cbegin() + 3, ID, "Ivan"s);
         assert(v.Size() == SIZE + 1);
         assert(&*pos == &v[3]);
         assert(v[3].id == ID);
@@ -532,11 +650,24 @@ void Test6() {
         assert(Obj::num_move_assigned == SIZE - 3);
         assert(Obj::num_assigned == 0);
     }
+    {
+        // A nothrow move constructs the new element right in its slot
+        Obj::ResetCounters();
+        Vector<Obj> v{SIZE};
+        v.Reserve(SIZE * 2);
+        const int old_num_moved = Obj::num_moved;
+        auto pos = v.Insert(v.cbegin() + 3, Obj{ID});
+        assert(&*pos == &v[3] && v[3].id == ID);
+        assert(Obj::num_moved == old_num_moved + 2);
+        assert(Obj::num_move_assigned == SIZE - 4);
+        assert(Obj::num_copied == 0);
+        assert(Obj::GetAliveObjectCount() == SIZE + 1);
+    }
     {
         Obj::ResetCounters();
         Vector<Obj> v{SIZE};
         v[2].id = ID;
-        auto* pos = v.Erase(v.cbegin() + 1);
+        auto pos = v.Erase(v.cbegin() + 1);
         assert((pos - v.begin()) == 1);
         assert(v.Size() == SIZE - 1);
         assert(v.Capacity() == SIZE);
@@ -549,6 +680,510 @@ void Test6() {
     }
 }
 
+void Test7() {
+    const size_t SIZE = 10;
+    const int ID = 42;
+    {
+        using Alloc = TrackingAllocator<Obj, true>;
+        Obj::ResetCounters();
+        Alloc::ResetCounters();
+        {
+            Vector<Obj, Alloc> v(SIZE, Alloc{1});
+            v[0].id = ID;
+            Vector<Obj, Alloc> v_other(Alloc{2});
+            v_other = std::move(v);
+            assert(v_other.GetAllocator().id == 1);
+            assert(v_other.Size() == SIZE);
+            assert(v_other[0].id == ID);
+            assert(Obj::num_moved == 0);
+
+            Vector<Obj, Alloc> v_copy(Alloc{3});
+            v_copy = v_other;
+            assert(v_copy.GetAllocator().id == 1);
+            assert(v_copy[0].id == ID);
+        }
+        assert(Alloc::num_allocations == Alloc::num_deallocations);
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        using Alloc = TrackingAllocator<Obj, false>;
+        Obj::ResetCounters();
+        Alloc::ResetCounters();
+        {
+            Vector<Obj, Alloc> v(SIZE, Alloc{1});
+            v[0].id = ID;
+            Vector<Obj, Alloc> v_other(Alloc{2});
+            v_other = std::move(v);
+            assert(v_other.GetAllocator().id == 2);
+            assert(v_other.Size() == SIZE);
+            assert(v_other[0].id == ID);
+            assert(Obj::num_moved == SIZE);
+
+            Vector<Obj, Alloc> v_moved(std::move(v_other), Alloc{3});
+            assert(v_moved.GetAllocator().id == 3);
+            assert(v_moved[0].id == ID);
+            assert(Obj::num_moved == SIZE * 2);
+
+            v_moved.PushBack(Obj{ID});
+            assert(v_moved.GetAllocator().id == 3);
+        }
+        assert(Alloc::num_allocations == Alloc::num_deallocations);
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+}
+
+void Test8() {
+    static_assert(is_trivially_relocatable_v<int>);
+    static_assert(is_trivially_relocatable_v<std::unique_ptr<int>>);
+    static_assert(!is_trivially_relocatable_v<std::string>);
+    static_assert(!is_trivially_relocatable_v<Obj>);
+
+    const size_t SIZE = 1000;
+    const int ID = 42;
+    {
+        RelocatableObj::ResetCounters();
+        Vector<RelocatableObj> v;
+        for (int i = 0; i < static_cast<int>(SIZE); ++i) {
+            v.EmplaceBack(i);
+        }
+        v.Reserve(SIZE * 4);
+        assert(v.Capacity() == SIZE * 4);
+        assert(RelocatableObj::num_moved == 0);
+        assert(RelocatableObj::num_destroyed == 0);
+        for (int i = 0; i < static_cast<int>(SIZE); ++i) {
+            assert(*v[i].value == i);
+        }
+    }
+    {
+        Vector<int, MallocAllocator<int>> v;
+        for (int i = 0; i < static_cast<int>(SIZE); ++i) {
+            v.PushBack(i);
+        }
+        v.Insert(v.begin(), ID);
+        assert(v.Size() == SIZE + 1);
+        v.Insert(v.begin() + 1, v[0]);
+        assert(v[0] == ID && v[1] == ID);
+        for (size_t i = 2; i < v.Size(); ++i) {
+            assert(v[i] == static_cast<int>(i - 2));
+        }
+        v.Reserve(SIZE * 10);
+        assert(v.Capacity() == SIZE * 10);
+        assert(v[SIZE + 1] == static_cast<int>(SIZE - 1));
+    }
+    {
+        Vector<std::unique_ptr<int>, MallocAllocator<std::unique_ptr<int>>> v;
+        for (int i = 0; i < static_cast<int>(SIZE); ++i) {
+            v.EmplaceBack(std::make_unique<int>(i));
+        }
+        for (int i = 0; i < static_cast<int>(SIZE); ++i) {
+            assert(*v[i] == i);
+        }
+    }
+}
+
+template <typename Vec>
+std::vector<size_t> CollectCapacities(size_t count) {
+    std::vector<size_t> capacities;
+    Vec v;
+    for (size_t i = 0; i < count; ++i) {
+        if (v.Size() == v.Capacity()) {
+            v.EmplaceBack();
+            capacities.push_back(v.Capacity());
+        } else {
+            v.EmplaceBack();
+        }
+    }
+    return capacities;
+}
+
+void Test9() {
+    {
+        const auto capacities = CollectCapacities<Vector<int>>(9);
+        assert((capacities == std::vector<size_t>{1, 2, 4, 8, 16}));
+    }
+    {
+        const auto capacities = CollectCapacities<Vector<int, std::allocator<int>, OneAndHalfGrowth<>>>(14);
+        assert((capacities == std::vector<size_t>{4, 6, 9, 13, 19}));
+    }
+    {
+        using Growth = SizeClassGrowth<DoublingGrowth<>>;
+        const auto capacities = CollectCapacities<Vector<int, std::allocator<int>, Growth>>(100);
+        assert((capacities == std::vector<size_t>{4, 8, 16, 32, 64, 128}));
+        assert(Growth::RoundToSizeClass(17) == 32);
+        assert(Growth::RoundToSizeClass(100) == 112);
+        assert(Growth::RoundToSizeClass(5000) == 8192);
+        assert(Growth::NextCapacity(0, 7, 12) == 8);
+    }
+    {
+        using Growth = CappedGrowth<1024>;
+        const auto capacities = CollectCapacities<Vector<int, std::allocator<int>, Growth>>(1000);
+        assert((capacities == std::vector<size_t>{1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 768, 1024}));
+        assert(Growth::NextCapacity(256, 2000, sizeof(int)) == 2000);
+    }
+    {
+        Obj::ResetCounters();
+        Vector<Obj, std::allocator<Obj>, DoublingGrowth<8>> v;
+        v.EmplaceBack(1);
+        assert(v.Capacity() == 8);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+}
+
+void Test10() {
+    const size_t SIZE = 1000;
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v;
+        size_t num_reallocations = 0;
+        for (size_t i = 0; i < SIZE; ++i) {
+            const size_t old_capacity = v.Capacity();
+            v.Resize(v.Size() + 1);
+            num_reallocations += v.Capacity() != old_capacity ? 1 : 0;
+        }
+        assert(v.Size() == SIZE);
+        assert(v.Capacity() == 1024);
+        assert(num_reallocations == 11);
+        assert(Obj::num_default_constructed == SIZE);
+        assert(Obj::num_moved == 1023);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Vector<int> v;
+        v.Resize(SIZE);
+        assert(v.Capacity() == SIZE);
+        v.Resize(SIZE + 1);
+        assert(v.Capacity() == SIZE * 2);
+        v.ReserveExact(SIZE * 2 + 1);
+        assert(v.Capacity() == SIZE * 2 + 1);
+        v.ReserveExact(SIZE);
+        assert(v.Capacity() == SIZE * 2 + 1);
+        assert(v.Size() == SIZE + 1);
+    }
+}
+
+void Test11() {
+    const size_t N = 4;
+    const int ID = 42;
+    using Alloc = TrackingAllocator<Obj, false>;
+    using SmallObjVector = SmallVector<Obj, N, Alloc>;
+    {
+        Obj::ResetCounters();
+        Alloc::ResetCounters();
+        {
+            SmallObjVector v;
+            assert(v.IsInline());
+            assert(v.Capacity() == N);
+            for (int i = 0; i < static_cast<int>(N); ++i) {
+                v.EmplaceBack(i);
+            }
+            assert(v.IsInline());
+            assert(Alloc::num_allocations == 0);
+
+            v.Insert(v.cbegin() + 1, Obj{ID});
+            assert(!v.IsInline());
+            assert(v.Capacity() == N * 2);
+            assert(Alloc::num_allocations == 1);
+            assert(v.Size() == N + 1);
+            assert(v[0].id == 0 && v[1].id == ID && v[2].id == 1 && v[N].id == static_cast<int>(N - 1));
+
+            v.Erase(v.cbegin() + 1);
+            assert(v.Size() == N);
+            assert(v[1].id == 1);
+            v.PopBack();
+            assert(v.Size() == N - 1);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+        assert(Alloc::num_allocations == Alloc::num_deallocations);
+    }
+    {
+        Obj::ResetCounters();
+        SmallObjVector inline_v(N - 1);
+        inline_v[0].id = ID;
+        SmallObjVector heap_v(N * 3);
+        heap_v[0].id = ID + 1;
+        assert(inline_v.IsInline() && !heap_v.IsInline());
+
+        // Unequal allocators that do not propagate make the inline fallback
+        // allocate
+        static_assert(!noexcept(inline_v.Swap(heap_v)));
+        static_assert(noexcept(std::declval<SmallVector<Obj, N>&>().Swap(std::declval<SmallVector<Obj, N>&>())));
+        inline_v.Swap(heap_v);
+        assert(!inline_v.IsInline() && inline_v.Size() == N * 3 && inline_v[0].id == ID + 1);
+        assert(heap_v.Size() == N - 1 && heap_v[0].id == ID);
+
+        SmallObjVector moved(std::move(heap_v));
+        assert(moved.IsInline() && moved.Size() == N - 1 && moved[0].id == ID);
+        assert(heap_v.Size() == 0);
+
+        const Obj* heap_data = &inline_v[0];
+        SmallObjVector stolen(std::move(inline_v));
+        assert(&stolen[0] == heap_data);
+
+        moved = stolen;
+        assert(moved.Size() == N * 3 && moved[0].id == ID + 1);
+        stolen.Resize(1);
+        assert(stolen.Size() == 1 && stolen.Capacity() == N * 3);
+        moved = std::move(stolen);
+        assert(moved.Size() == 1 && moved[0].id == ID + 1);
+        assert(stolen.Size() == 0);
+        assert(Obj::GetAliveObjectCount() == 1);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        SmallVector<int, N> v;
+        v.Resize(N);
+        assert(v.IsInline());
+        v.Resize(N + 1);
+        assert(v.Capacity() == N * 2);
+        v.Reserve(N * 10);
+        assert(v.Capacity() == N * 10);
+        SmallVector<TestObj, N> objs(N);
+        objs.PushBack(objs[0]);
+        assert(std::all_of(objs.begin(), objs.end(), [](const TestObj& obj) {
+            return obj.IsAlive();
+        }));
+    }
+}
+
+void Test12() {
+    using namespace std::literals;
+    const size_t SIZE = 10;
+    const int ID = 42;
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        v.Reserve(SIZE * 2);
+        std::vector<Obj> src(3, Obj{ID});
+        const int old_num_copied = Obj::num_copied;
+        const int old_num_moved = Obj::num_moved;
+        auto pos = v.Insert(v.cbegin() + 2, src.begin(), src.end());
+        assert(pos == v.begin() + 2);
+        assert(v.Size() == SIZE + 3);
+        assert(v[1].id == 0 && v[2].id == ID && v[4].id == ID && v[5].id == 0);
+        assert(Obj::num_copied == old_num_copied);
+        assert(Obj::num_assigned == 3);
+        assert(Obj::num_moved == old_num_moved + 3);
+        assert(Obj::num_move_assigned == SIZE - 2 - 3);
+
+        std::vector<Obj> large_src(SIZE, Obj{ID + 1});
+        const int large_num_copied = Obj::num_copied;
+        const int large_num_moved = Obj::num_moved;
+        v.Insert(v.cbegin() + v.Size() - 2, large_src.begin(), large_src.end());
+        assert(v.Size() == SIZE * 2 + 3);
+        assert(v.Capacity() == SIZE * 4);
+        assert(v[SIZE + 1].id == ID + 1 && v[SIZE * 2 + 1].id == 0);
+        assert(Obj::num_copied == large_num_copied + static_cast<int>(SIZE));
+        assert(Obj::num_moved == large_num_moved + static_cast<int>(SIZE + 3));
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        std::vector<Obj> src(SIZE);
+        src[SIZE / 2].throw_on_copy = true;
+        try {
+            v.Insert(v.cbegin() + 1, src.begin(), src.end());
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == SIZE);
+        assert(v.Capacity() == SIZE);
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE * 2));
+    }
+    {
+        Vector<std::string> v;
+        v.Insert(v.cbegin(), 3, "x"s);
+        v.Insert(v.cbegin() + 1, 2, v[0]);
+        assert(v.Size() == 5);
+        assert(std::all_of(v.begin(), v.end(), [](const std::string& str) {
+            return str == "x"s;
+        }));
+        const std::string words[] = {"a"s, "b"s, "c"s, "d"s, "e"s, "f"s, "g"s};
+        v.Reserve(100);
+        v.Insert(v.cbegin() + 4, std::begin(words), std::begin(words) + 2);
+        v.Insert(v.cbegin() + 1, std::begin(words), std::end(words));
+        const Vector<std::string> expected_range(std::begin(words), std::end(words));
+        assert(std::equal(v.begin() + 1, v.begin() + 8, expected_range.begin(), expected_range.end()));
+        assert(v[0] == "x"s && v[8] == "x"s && v[11] == "a"s && v[12] == "b"s && v[13] == "x"s);
+        assert(v.Size() == 14);
+    }
+    {
+        Vector<int> v;
+        v.Insert(v.cbegin(), SIZE, ID);
+        v.Insert(v.cbegin() + 1, 2, v[0] + 1);
+        assert(v.Size() == SIZE + 2);
+        assert(v[0] == ID && v[1] == ID + 1 && v[2] == ID + 1 && v[3] == ID);
+        const std::vector<int> src{1, 2, 3};
+        v.Append(src.begin(), src.end());
+        assert(v.Size() == SIZE + 5);
+        assert(v[SIZE + 2] == 1 && v[SIZE + 4] == 3);
+
+        std::istringstream input("7 8 9");
+        v.Insert(v.cbegin() + 1, std::istream_iterator<int>(input), std::istream_iterator<int>());
+        assert(v.Size() == SIZE + 8);
+        assert(v[0] == ID && v[1] == 7 && v[2] == 8 && v[3] == 9 && v[4] == ID + 1);
+        assert(v[SIZE + 7] == 3);
+    }
+}
+
+void Test13() {
+    const size_t SIZE = 10;
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        for (size_t i = 0; i < SIZE; ++i) {
+            v[i].id = static_cast<int>(i);
+        }
+        auto pos = v.Erase(v.cbegin() + 2, v.cbegin() + 5);
+        assert(pos == v.begin() + 2);
+        assert(v.Size() == SIZE - 3);
+        assert(v[1].id == 1 && v[2].id == 5 && v[SIZE - 4].id == static_cast<int>(SIZE - 1));
+        assert(Obj::num_move_assigned == static_cast<int>(SIZE - 5));
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE - 3));
+
+        pos = v.Erase(v.cbegin() + 1, v.cbegin() + 1);
+        assert(pos == v.begin() + 1);
+        assert(v.Size() == SIZE - 3);
+
+        const size_t removed = v.EraseIf([](const Obj& obj) {
+            return obj.id % 2 == 1;
+        });
+        assert(removed == 4);
+        assert(v.Size() == SIZE - 7);
+        assert(v[0].id == 0 && v[1].id == 6 && v[2].id == 8);
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE - 7));
+
+        v.Erase(v.cbegin(), v.cend());
+        assert(v.Size() == 0);
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        Vector<int> v;
+        for (int i = 0; i < 1000; ++i) {
+            v.PushBack(i);
+        }
+        assert(v.EraseIf([](int value) {
+            return value % 3 != 0;
+        }) == 666);
+        assert(v.Size() == 334);
+        for (size_t i = 0; i < v.Size(); ++i) {
+            assert(v[i] == static_cast<int>(i) * 3);
+        }
+        v.Erase(v.cbegin() + 1, v.cend() - 1);
+        assert(v.Size() == 2 && v[0] == 0 && v[1] == 999);
+    }
+    {
+        RelocatableObj::ResetCounters();
+        Vector<RelocatableObj> v;
+        for (int i = 0; i < static_cast<int>(SIZE); ++i) {
+            v.EmplaceBack(i);
+        }
+        v.Erase(v.cbegin(), v.cbegin() + 3);
+        assert(RelocatableObj::num_destroyed == 3);
+        assert(RelocatableObj::num_moved == 0);
+        assert(v.Size() == SIZE - 3 && *v[0].value == 3);
+    }
+}
+
+void Test14() {
+    const size_t SIZE = 100;
+    const int ID = 42;
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE, DEFAULT_INIT);
+        assert(v.Size() == SIZE && v.Capacity() == SIZE);
+        assert(Obj::num_default_constructed == SIZE);
+        v.ResizeDefaultInit(SIZE / 2);
+        assert(v.Size() == SIZE / 2);
+        v.ResizeDefaultInit(SIZE * 3);
+        assert(v.Size() == SIZE * 3);
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE * 3));
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Vector<int> v(SIZE, DEFAULT_INIT);
+        std::fill(v.begin(), v.end(), ID);
+        v.ResizeAndOverwrite(SIZE * 4, [](int* data, size_t max_size) {
+            assert(data[SIZE - 1] == ID);
+            for (size_t i = SIZE; i < max_size; ++i) {
+                data[i] = static_cast<int>(i);
+            }
+            return max_size - 1;
+        });
+        assert(v.Size() == SIZE * 4 - 1);
+        assert(v[SIZE - 1] == ID && v[SIZE] == static_cast<int>(SIZE));
+        assert(v[SIZE * 4 - 2] == static_cast<int>(SIZE * 4 - 2));
+
+        try {
+            v.ResizeAndOverwrite(SIZE * 10, [](int*, size_t) -> size_t {
+                throw std::runtime_error("Oops");
+            });
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == SIZE * 4 - 1);
+
+        v.ResizeAndOverwrite(2, [](int* data, size_t) {
+            data[1] = ID + 1;
+            return size_t{2};
+        });
+        assert(v.Size() == 2 && v[0] == ID && v[1] == ID + 1);
+    }
+}
+
+void Test15() {
+    const size_t SIZE = 100;
+    const int ID = 42;
+    {
+        Obj::ResetCounters();
+        using Alloc = TrackingAllocator<Obj, true>;
+        Alloc::ResetCounters();
+        {
+            Vector<Obj, Alloc> v(SIZE);
+            Vector<Obj, Alloc> v_other(SIZE / 2);
+            v_other[0].id = ID;
+            v = std::move(v_other);
+            assert(v.Size() == SIZE / 2);
+            assert(v[0].id == ID);
+            assert(v_other.Size() == 0);
+            assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE / 2));
+            assert(Obj::num_destroyed == static_cast<int>(SIZE));
+            assert(Alloc::num_deallocations == 1);
+
+            v = std::move(v);
+            assert(v.Size() == SIZE / 2);
+            assert(v[0].id == ID);
+            assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE / 2));
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+        assert(Alloc::num_allocations == Alloc::num_deallocations);
+    }
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        for (int i = 0; i < 10; ++i) {
+            Vector<Obj> v_other(SIZE);
+            v = std::move(v_other);
+            assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE));
+        }
+        v = Vector<Obj>{};
+        assert(v.Size() == 0 && v.Capacity() == 0);
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        RawMemory<int> memory(SIZE);
+        RawMemory<int> other(SIZE * 2);
+        const int* other_buffer = other.GetAddress();
+        memory = std::move(other);
+        assert(memory.GetAddress() == other_buffer);
+        assert(memory.Capacity() == SIZE * 2);
+        assert(other.GetAddress() == nullptr && other.Capacity() == 0);
+        RawMemory<int> moved(std::move(memory));
+        assert(moved.GetAddress() == other_buffer);
+        assert(memory.GetAddress() == nullptr);
+    }
+}
+
 struct C {
     C() noexcept {
         ++def_ctor;
@@ -590,44 +1225,1313 @@ struct C {
     inline static size_t dtor = 0;
 };
 
-void Dump() {
-    using namespace std;
-    cerr << "Def ctors: "sv << C::def_ctor
-         << ", Copy ctors: "sv << C::copy_ctor
-         << ", Move ctors: "sv << C::move_ctor
-         << ", Copy assignments: "sv << C::copy_assign
-         << ", Move assignments: "sv << C::move_assign
-         << ", Dtors: "sv << C::dtor << endl;
+// Vector must perform exactly the element operations std::vector does when
+// growing a full vector by one copied element
+void Test16() {
+    const size_t NUM = 10;
+    C c;
+    {
+        C::Reset();
+        Vector<C> v(NUM);
+        assert(C::def_ctor == NUM);
+        assert(C::dtor == 0);
+        v.PushBack(c);
+    }
+    assert(C::def_ctor == NUM);
+    assert(C::copy_ctor == 1);
+    assert(C::move_ctor == NUM);
+    assert(C::copy_assign == 0);
+    assert(C::move_assign == 0);
+    assert(C::dtor == NUM * 2 + 1);
 }
 
-void Benchmark() {
-    using namespace std;
-    try {
-        const size_t NUM = 10;
-        C c;
-        {
-            cerr << "std::vector:"sv << endl;
-            C::Reset();
-            vector<C> v(NUM);
-            Dump();
-            v.push_back(c);
+struct InstrumentedSite {
+    static constexpr const char* NAME = "test-site";
+};
+
+void Test17() {
+    using Instrumentation = CountingInstrumentation<InstrumentedSite>;
+    using InstrumentedVector = Vector<int, std::allocator<int>, DoublingGrowth<>, Instrumentation>;
+    const size_t SIZE = 100;
+    Instrumentation::Reset();
+    {
+        InstrumentedVector v;
+        for (int i = 0; i < static_cast<int>(SIZE); ++i) {
+            v.PushBack(i);
         }
-        Dump();
-    } catch (...) {
+        VectorStats stats = Instrumentation::GetStats();
+        assert(stats.reallocations == 8);
+        assert(stats.relocated_bytes == (1 + 2 + 4 + 8 + 16 + 32 + 64) * sizeof(int));
+        assert(stats.peak_size == SIZE);
+        assert(stats.peak_capacity == 128);
+        assert(stats.shifted_elements == 0);
+
+        v.Insert(v.cbegin() + 10, 5);
+        v.Erase(v.cbegin());
+        v.Erase(v.cbegin() + 10, v.cbegin() + 20);
+        stats = Instrumentation::GetStats();
+        assert(stats.shifted_elements == (SIZE - 10) + SIZE + (SIZE - 20));
+        assert(stats.peak_size == SIZE + 1);
+
+        v.Reserve(1000);
+        stats = Instrumentation::GetStats();
+        assert(stats.reallocations == 9);
+        assert(stats.peak_capacity == 1000);
     }
-    try {
-        const size_t NUM = 10;
-        C c;
-        {
-            cerr << "Vector:"sv << endl;
-            C::Reset();
-            Vector<C> v(NUM);
-            Dump();
-            v.PushBack(c);
+    bool found = false;
+    ForEachInstrumentedSite([&found](const std::string& name, const VectorStats& stats) {
+        if (name == "test-site") {
+            found = true;
+            assert(stats.reallocations == 9);
         }
-        Dump();
-    } catch (...) {
+    });
+    assert(found);
+    static_assert(sizeof(Vector<int>) == sizeof(InstrumentedVector));
+}
+
+// Buffers of VirtualMemoryAllocator grow in place until the reservation is
+// exhausted, after which Vector falls back to relocation
+void Test18() {
+    const size_t RESERVE_BYTES = size_t{1} << 20;
+    // DoublingGrowth reaches exactly this capacity without leaving the reservation
+    size_t in_place_size = 1;
+    while (in_place_size * 2 * sizeof(Obj) <= RESERVE_BYTES) {
+        in_place_size *= 2;
+    }
+    const size_t IN_PLACE_SIZE = in_place_size;
+    Obj::ResetCounters();
+    {
+        VirtualMemoryAllocator<Obj> alloc(VirtualMemoryOptions{RESERVE_BYTES, HugePages::NONE});
+        Vector<Obj, VirtualMemoryAllocator<Obj>> v(alloc);
+        v.EmplaceBack(0);
+        const Obj* first = &v[0];
+        for (size_t i = 1; i < IN_PLACE_SIZE; ++i) {
+            v.EmplaceBack(static_cast<int>(i));
+        }
+        assert(&v[0] == first);
+        assert(v.Capacity() == IN_PLACE_SIZE);
+        assert(Obj::num_moved == 0 && Obj::num_copied == 0);
+
+        v.Insert(v.cbegin(), Obj(-1));
+        assert(&v[0] != first);
+        v.EmplaceBack(-2);
+        assert(v.Size() == IN_PLACE_SIZE + 2);
+        assert(v[0].id == -1 && v[1].id == 0 && v[IN_PLACE_SIZE + 1].id == -2);
+        for (size_t i = 1; i <= IN_PLACE_SIZE; ++i) {
+            assert(v[i].id == static_cast<int>(i - 1));
+        }
+
+        Vector<int, VirtualMemoryAllocator<int>> ints;
+        ints.Reserve(10);
+        const int* ints_data = ints.Data();
+        ints.Reserve(1000);
+        assert(ints.Data() == ints_data);
+        assert(ints.Capacity() == 1000);
+
+        // Growing in place while filling with an element of the vector
+        Vector<int, VirtualMemoryAllocator<int>> filled;
+        filled.Reserve(4);
+        for (const int value : {0, 10, 20, 30}) {
+            filled.PushBack(value);
+        }
+        const int* filled_data = filled.Data();
+        filled.Insert(filled.cbegin(), 3, filled[3]);
+        assert(filled.Data() == filled_data);
+        const int expected[] = {30, 30, 30, 0, 10, 20, 30};
+        assert(std::equal(filled.begin(), filled.end(), std::begin(expected), std::end(expected)));
+
+        // Sizes that overflow are refused rather than thrown from noexcept
+        VirtualMemoryAllocator<int> ints_alloc;
+        int* buffer = ints_alloc.allocate(1);
+        assert(!ints_alloc.expand_in_place(buffer, 1, std::numeric_limits<size_t>::max()));
+        assert(!ints_alloc.expand_in_place(buffer, 1, std::numeric_limits<size_t>::max() / sizeof(int)));
+        ints_alloc.deallocate(buffer, 1);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+}
+
+// PersistentVector reopens its file with the elements in place and rejects
+// files written for another element type
+void Test19() {
+    struct Record {
+        int id;
+        double value;
+    };
+    const std::string path = "persistent_vector_test.bin";
+    const size_t SIZE = 1000;
+    std::remove(path.c_str());
+    {
+        PersistentVector<Record> v(path, FileMode::READ_WRITE);
+        assert(v.Size() == 0 && v.Capacity() == 0);
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.PushBack({static_cast<int>(i), i * 0.5});
+        }
+        v.PopBack();
+        v.Sync();
+    }
+    {
+        const PersistentVector<Record> v(path, FileMode::READ_ONLY);
+        assert(v.IsReadOnly());
+        assert(v.Size() == SIZE - 1);
+        assert(v.Capacity() == 1024);
+        for (size_t i = 0; i < v.Size(); ++i) {
+            assert(v[i].id == static_cast<int>(i) && v[i].value == i * 0.5);
+        }
+    }
+    {
+        PersistentVector<Record> v(path, FileMode::READ_WRITE);
+        v.EmplaceBack(Record{-1, -1.0});
+        v.Resize(SIZE + 1);
+        assert(v[SIZE - 1].id == -1 && v[SIZE].id == 0);
+        PersistentVector<Record> moved(std::move(v));
+        assert(moved.Size() == SIZE + 1);
+    }
+    {
+        const PersistentVector<Record> v(path, FileMode::READ_ONLY);
+        assert(v.Size() == SIZE + 1 && v[SIZE - 1].value == -1.0);
+    }
+    {
+        // The elements of a read-only vector are mapped without write access
+        PersistentVector<Record> v(path, FileMode::READ_ONLY);
+        assert(std::as_const(v)[0].id == 0);
+        size_t refused = 0;
+        for (auto write : {+[](PersistentVector<Record>& v) { v[0].id = 1; },
+                           +[](PersistentVector<Record>& v) { v.begin()->id = 1; },
+                           +[](PersistentVector<Record>& v) { v.PushBack({}); },
+                           +[](PersistentVector<Record>& v) { v.PopBack(); }}) {
+            try {
+                write(v);
+            } catch (const std::logic_error&) {
+                ++refused;
+            }
+        }
+        assert(refused == 4 && v.Size() == SIZE + 1);
+    }
+    {
+        // Growing remaps the file, so an element of the vector must be read
+        // before its old mapping goes away
+        PersistentVector<Record> v(path, FileMode::READ_WRITE);
+        v.Resize(v.Capacity());
+        const size_t capacity = v.Capacity();
+        v.PushBack(v[5]);
+        assert(v.Capacity() > capacity);
+        assert(v.Size() == capacity + 1 && v[capacity].id == 5 && v[capacity].value == 2.5);
+    }
+    try {
+        PersistentVector<int> v(path, FileMode::READ_ONLY);
+        assert(false);
+    } catch (const std::runtime_error&) {
+    }
+    std::remove(path.c_str());
+    try {
+        PersistentVector<Record> v(path, FileMode::READ_ONLY);
+        assert(false);
+    } catch (const std::system_error&) {
+    }
+}
+
+template <typename T>
+bool IsAligned(const T* p, size_t alignment) {
+    return reinterpret_cast<uintptr_t>(p) % alignment == 0;
+}
+
+// Buffers honor both the requested alignment and over-aligned element types
+void Test20() {
+    AlignedVector<float> floats;
+    for (int i = 0; i < 1000; ++i) {
+        floats.PushBack(static_cast<float>(i));
+        assert(IsAligned(&floats[0], CACHE_LINE_SIZE));
+    }
+    AlignedVector<float> copy(floats);
+    assert(IsAligned(&copy[0], CACHE_LINE_SIZE) && copy[999] == 999.0f);
+
+    AlignedVector<double, 4096> paged(10);
+    assert(IsAligned(&paged[0], 4096));
+
+    struct alignas(128) Wide {
+        char bytes[16];
+    };
+    Vector<Wide> wide(3);
+    wide.Reserve(100);
+    assert(IsAligned(&wide[0], 128));
+    static_assert(AlignedAllocator<Wide, 16>::ALIGNMENT == 128);
+    AlignedVector<Wide, 16> wide_aligned(5);
+    assert(IsAligned(&wide_aligned[0], 128));
+}
+
+// SoAVector keeps each field in its own aligned column and leaves its rows
+// intact when constructing a row throws
+void Test21() {
+    const int SIZE = 100;
+    Obj::ResetCounters();
+    {
+        SoAVector<int, double, Obj> v;
+        for (int i = 0; i < SIZE; ++i) {
+            v.EmplaceBack(i, i * 0.5, i);
+        }
+        assert(v.Size() == static_cast<size_t>(SIZE) && v.Capacity() == 128);
+        assert(IsAligned(v.Column<0>().Data(), CACHE_LINE_SIZE));
+        assert(IsAligned(v.Column<1>().Data(), CACHE_LINE_SIZE));
+        assert(IsAligned(v.Column<2>().Data(), CACHE_LINE_SIZE));
+        double sum = 0;
+        for (double value : v.Column<1>()) {
+            sum += value;
+        }
+        assert(sum == (SIZE - 1) * SIZE / 4.0);
+
+        v.Erase(0);
+        v.Erase(10, 20);
+        assert(v.Size() == static_cast<size_t>(SIZE - 11));
+        assert(v.Get<0>(0) == 1 && v.Get<2>(10).id == 21);
+        auto [id, value, obj] = v[10];
+        assert(id == 21 && value == 10.5 && obj.id == 21);
+        std::get<0>(v[10]) = -1;
+        assert(v.Column<0>()[10] == -1);
+
+        v.PopBack();
+        v.Resize(SIZE);
+        assert(v.Get<0>(SIZE - 1) == 0 && v.Get<2>(SIZE - 1).id == 0);
+        assert(Obj::GetAliveObjectCount() == SIZE);
+
+        SoAVector<int, double, Obj> copy(v);
+        assert(copy.Size() == v.Size() && copy.Get<2>(10).id == v.Get<2>(10).id);
+
+        Obj throwing(7);
+        throwing.throw_on_copy = true;
+        SoAVector<int, double, Obj> full(4);
+        assert(full.Size() == full.Capacity());
+        try {
+            full.EmplaceBack(1, 1.0, throwing);
+            assert(false);
+        } catch (const std::runtime_error&) {
+        }
+        assert(full.Size() == 4 && full.Capacity() == 4);
+        try {
+            v.PushBack(2, 2.0, throwing);
+            assert(false);
+        } catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == static_cast<size_t>(SIZE));
+        assert(Obj::GetAliveObjectCount() == 2 * SIZE + 1 + 4);
+
+        copy = std::move(v);
+        assert(v.Size() == 0 && copy.Size() == static_cast<size_t>(SIZE));
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+}
+
+template <typename T>
+void CheckBulkAlgorithms(size_t size) {
+    Vector<T> v(size);
+    for (size_t i = 0; i < size; ++i) {
+        v[i] = static_cast<T>((i * 7919) % 101) - static_cast<T>(50);
+    }
+    const T* first = v.Data();
+    const T* last = first + size;
+    assert(Find(v, T(3)) == std::find(first, last, T(3)));
+    assert(Find(v, T(1000)) == last);
+    assert(Count(v, T(-50)) == static_cast<size_t>(std::count(first, last, T(-50))));
+    assert(Sum(v) == std::accumulate(first, last, T{}));
+    if (size > 0) {
+        const auto [min, max] = MinMax(v);
+        assert(min == *std::min_element(first, last) && max == *std::max_element(first, last));
+    }
+    Vector<T> doubled(size);
+    Transform(v, doubled.Data(), [](T x) {
+        return x * 2;
+    });
+    for (size_t i = 0; i < size; ++i) {
+        assert(doubled[i] == v[i] * 2);
+    }
+    Fill(v, T(9));
+    assert(Count(v, T(9)) == size);
+}
+
+// Every instruction set the CPU supports gives the results of the std
+// algorithms, including for tails shorter than a vector
+void Test22() {
+    const SimdLevel default_level = GetSimdLevel();
+    for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512, SimdLevel::NEON}) {
+        if (!SetSimdLevel(level)) {
+            continue;
+        }
+        assert(GetSimdLevel() == level);
+        for (size_t size : {0, 1, 3, 15, 16, 17, 63, 64, 100, 1000}) {
+            CheckBulkAlgorithms<int32_t>(size);
+            CheckBulkAlgorithms<int64_t>(size);
+            CheckBulkAlgorithms<float>(size);
+            CheckBulkAlgorithms<double>(size);
+        }
+    }
+    assert(SetSimdLevel(default_level));
+
+    Vector<std::string> strings;
+    strings.PushBack("a");
+    strings.PushBack("b");
+    strings.PushBack("a");
+    assert(Count(strings, std::string("a")) == 2);
+    assert(Find(strings, std::string("b")) == &strings[1]);
+    assert(MinMax(strings).second == "b");
+}
+
+// Counts live objects with atomics, so it can be used from several threads
+struct SharedObj {
+    SharedObj() {
+        if (construction_throw_countdown.fetch_sub(1) == 1) {
+            throw std::runtime_error("Oops");
+        }
+        ++num_alive;
+    }
+
+    SharedObj(const SharedObj& other)
+        : id(other.id)
+    {
+        if (other.throw_on_copy) {
+            throw std::runtime_error("Oops");
+        }
+        ++num_alive;
+    }
+
+    SharedObj(SharedObj&& other) noexcept
+        : id(other.id)
+    {
+        ++num_alive;
+    }
+
+    SharedObj& operator=(const SharedObj& other) {
+        id = other.id;
+        return *this;
+    }
+
+    ~SharedObj() {
+        --num_alive;
+    }
+
+    int id = 0;
+    bool throw_on_copy = false;
+
+    static inline std::atomic<int> num_alive = 0;
+    // The constructor call that brings it from 1 to 0 throws
+    static inline std::atomic<int> construction_throw_countdown = 0;
+};
+
+// ParallelExecution splits construction, copies, relocation and destruction
+// into chunks and rolls back the completed chunks when one of them throws
+void Test23() {
+    using ParallelVector =
+        Vector<SharedObj, std::allocator<SharedObj>, DoublingGrowth<>, NoInstrumentation, ParallelExecution<64, 4>>;
+    const size_t SIZE = 10000;
+    {
+        ParallelVector v(SIZE);
+        assert(SharedObj::num_alive == static_cast<int>(SIZE));
+        for (size_t i = 0; i < SIZE; ++i) {
+            v[i].id = static_cast<int>(i);
+        }
+        ParallelVector copy(v);
+        v.Reserve(SIZE * 2);
+        v.Resize(SIZE * 2);
+        assert(SharedObj::num_alive == static_cast<int>(SIZE * 3));
+        for (size_t i = 0; i < SIZE; ++i) {
+            assert(copy[i].id == static_cast<int>(i) && v[i].id == static_cast<int>(i));
+        }
+
+        v[SIZE / 2 + 123].throw_on_copy = true;
+        try {
+            ParallelVector failed_copy(v);
+            assert(false);
+        } catch (const std::runtime_error&) {
+        }
+        assert(SharedObj::num_alive == static_cast<int>(SIZE * 3));
+
+        SharedObj::construction_throw_countdown = SIZE / 3;
+        try {
+            ParallelVector failed(SIZE);
+            assert(false);
+        } catch (const std::runtime_error&) {
+        }
+        SharedObj::construction_throw_countdown = 0;
+        assert(SharedObj::num_alive == static_cast<int>(SIZE * 3));
+
+        v[SIZE / 2 + 123].throw_on_copy = false;
+        copy = v;
+        assert(copy.Size() == SIZE * 2 && copy[SIZE - 1].id == static_cast<int>(SIZE - 1));
+        v.Resize(SIZE / 2);
+        copy = v;
+        assert(copy.Size() == SIZE / 2 && SharedObj::num_alive == static_cast<int>(SIZE));
+    }
+    assert(SharedObj::num_alive == 0);
+}
+
+// Writers append concurrently without losing elements, and the address of
+// an element never changes
+void Test24() {
+    const int NUM_THREADS = 4;
+    const int PER_THREAD = 10000;
+    {
+        ConcurrentVector<SharedObj> v;
+        std::vector<std::vector<const SharedObj*>> addresses(NUM_THREADS);
+        std::vector<std::thread> writers;
+        for (int t = 0; t < NUM_THREADS; ++t) {
+            writers.emplace_back([&v, &addresses, t] {
+                SharedObj obj;
+                for (int i = 0; i < PER_THREAD; ++i) {
+                    obj.id = i * NUM_THREADS + t;
+                    addresses[t].push_back(&v.EmplaceBack(obj));
+                }
+            });
+        }
+        for (std::thread& writer : writers) {
+            writer.join();
+        }
+        assert(v.Size() == static_cast<size_t>(NUM_THREADS * PER_THREAD));
+        assert(SharedObj::num_alive == NUM_THREADS * PER_THREAD);
+        for (int t = 0; t < NUM_THREADS; ++t) {
+            for (int i = 0; i < PER_THREAD; ++i) {
+                assert(addresses[t][i]->id == i * NUM_THREADS + t);
+            }
+        }
+
+        Vector<SharedObj> flat = v.Flatten();
+        assert(flat.Size() == v.Size());
+        std::vector<bool> seen(flat.Size());
+        for (size_t i = 0; i < flat.Size(); ++i) {
+            assert(&v[i] == v.TryGet(i) && v[i].id == flat[i].id);
+            seen[flat[i].id] = true;
+        }
+        assert(std::find(seen.begin(), seen.end(), false) == seen.end());
+
+        SharedObj throwing;
+        throwing.throw_on_copy = true;
+        try {
+            v.PushBack(throwing);
+            assert(false);
+        } catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == flat.Size() + 1 && !v.IsConstructed(flat.Size()));
+        v.PushBack(SharedObj());
+        assert(v.IsConstructed(flat.Size() + 1) && v.Flatten().Size() == flat.Size() + 1);
+        assert(v.TryGet(v.Size()) == nullptr);
+    }
+    assert(SharedObj::num_alive == 0);
+}
+
+// Short-lived vectors of similar sizes reuse the buffers cached by their
+// thread, within the cache's byte limit
+void Test25() {
+    using CachingVector = Vector<int, CachingAllocator<int>>;
+    ClearThreadBufferCache();
+    ResetThreadBufferCacheStats();
+    for (int i = 0; i < 100; ++i) {
+        CachingVector v(10 + i % 5);
+        v.PushBack(i);
+    }
+    BufferCacheStats stats = GetThreadBufferCacheStats();
+    // 10..14 ints fit into the 64-byte class, the grown 20..28 into 128 bytes
+    assert(stats.misses == 2);
+    assert(stats.hits == 198);
+    assert(stats.cached_buffers == 2 && stats.cached_bytes == 64 + 128);
+
+    {
+        Vector<char, CachingAllocator<char>> large(MAX_CACHED_BUFFER_BYTES + 1);
+    }
+    assert(GetThreadBufferCacheStats().cached_buffers == 2);
+
+    // Shrinking the limit below the cached bytes empties the cache
+    SetThreadBufferCacheCapacity(128);
+    assert(GetThreadBufferCacheStats().cached_bytes == 0);
+    SetThreadBufferCacheCapacity(1024);
+    {
+        Vector<int, CachingAllocator<int>> a(200);
+        Vector<int, CachingAllocator<int>> b(200);
+    }
+    stats = GetThreadBufferCacheStats();
+    assert(stats.cached_buffers == 1 && stats.cached_bytes == 1024 && stats.evictions == 1);
+
+    // Buffers freed by another thread join that thread's cache
+    auto moved_in = std::make_unique<Vector<int, CachingAllocator<int>>>(100);
+    std::thread([&moved_in] {
+        moved_in.reset();
+        assert(GetThreadBufferCacheStats().cached_buffers == 1);
+    }).join();
+
+    SetThreadBufferCacheCapacity(size_t{4} << 20);
+    ClearThreadBufferCache();
+    assert(GetThreadBufferCacheStats().cached_bytes == 0);
+}
+
+struct ShrinkingSite {
+};
+
+// Throws an exception other than std::bad_alloc once the budget is spent
+template <typename T>
+struct FailingAllocator {
+    using value_type = T;
+
+    FailingAllocator() noexcept = default;
+
+    template <typename U>
+    FailingAllocator(const FailingAllocator<U>&) noexcept {
+    }
+
+    T* allocate(size_t n) {
+        if (allocations_left == 0) {
+            throw std::runtime_error("allocation budget exhausted");
+        }
+        --allocations_left;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template <typename U>
+    bool operator==(const FailingAllocator<U>&) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const FailingAllocator<U>&) const noexcept {
+        return false;
+    }
+
+    static inline size_t allocations_left = 0;
+};
+
+void Test26() {
+    const size_t SIZE = 100;
+    Obj::ResetCounters();
+    {
+        Vector<Obj> v(SIZE);
+        v.Reserve(SIZE * 4);
+        const int moved_before = Obj::num_moved;
+        v.ShrinkToFit();
+        assert(v.Size() == SIZE && v.Capacity() == SIZE);
+        assert(Obj::num_moved - moved_before == static_cast<int>(SIZE) && Obj::num_copied == 0);
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE));
+
+        v.Clear();
+        assert(v.Size() == 0 && v.Capacity() == SIZE);
+        assert(Obj::GetAliveObjectCount() == 0);
+        v.Resize(10);
+        v.Clear(ClearMode::RELEASE_CAPACITY);
+        assert(v.Size() == 0 && v.Capacity() == 0 && v.Data() == nullptr);
+        v.ShrinkToFit();
+        assert(v.Capacity() == 0);
+
+        v.Resize(5);
+        v.Reserve(SIZE);
+        v.Resize(0);
+        v.ShrinkToFit();
+        assert(v.Capacity() == 0 && v.Data() == nullptr);
+    }
+    {
+        // Trivially relocatable elements shrink through realloc
+        Vector<int, MallocAllocator<int>> v(SIZE);
+        std::iota(v.begin(), v.end(), 0);
+        v.Reserve(SIZE * 8);
+        v.ShrinkToFit();
+        assert(v.Capacity() == SIZE && v[SIZE - 1] == static_cast<int>(SIZE - 1));
+    }
+    {
+        // Shrinks to twice the size once fewer than a quarter of the slots are used
+        Vector<Obj, std::allocator<Obj>, ShrinkingGrowth<>> v;
+        for (int i = 0; i < 1024; ++i) {
+            v.EmplaceBack(i);
+        }
+        assert(v.Capacity() == 1024);
+        while (v.Size() > 256) {
+            v.PopBack();
+        }
+        assert(v.Capacity() == 1024);
+        v.PopBack();
+        assert(v.Size() == 255 && v.Capacity() == 510);
+        v.Erase(v.begin(), v.begin() + 100);
+        assert(v.Size() == 155 && v.Capacity() == 510);
+        v.EraseIf([](const Obj& obj) {
+            return obj.id % 2 == 0;
+        });
+        assert(v.Size() == 77 && v.Capacity() == 154);
+        assert(v[0].id == 101 && v[76].id == 253);
+        v.Resize(10);
+        assert(v.Capacity() == 20);
+        v.Resize(0);
+        assert(v.Capacity() == 0);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        using Instrumentation = CountingInstrumentation<ShrinkingSite>;
+        Instrumentation::Reset();
+        Vector<int, std::allocator<int>, ShrinkingGrowth<>, Instrumentation> v(64);
+        v.Resize(4);
+        const VectorStats stats = Instrumentation::GetStats();
+        assert(v.Capacity() == 8 && stats.reallocations == 1 && stats.relocated_bytes == 4 * sizeof(int));
+    }
+    {
+        // A failing shrink keeps the buffer instead of escaping PopBack
+        FailingAllocator<int>::allocations_left = 1;
+        Vector<int, FailingAllocator<int>, ShrinkingGrowth<>> v(64);
+        const int* data = v.Data();
+        while (v.Size() > 4) {
+            v.PopBack();
+        }
+        v.Erase(v.cbegin());
+        assert(v.Size() == 3 && v.Data() == data && v.Capacity() == 64);
+    }
+}
+
+// Middle insertion into spare capacity shifts the tail once and builds the
+// new element in place unless its arguments live in the shifted tail
+void Test27() {
+    const size_t NUM = 10;
+    {
+        Vector<C> v(NUM);
+        v.Reserve(NUM * 2);
+        C::Reset();
+        v.Emplace(v.cbegin() + 2);
+        assert(C::def_ctor == 1 && C::move_ctor == 1 && C::move_assign == NUM - 3);
+        assert(C::copy_ctor == 0 && C::copy_assign == 0 && C::dtor == 1);
+
+        const C outside;
+        C::Reset();
+        v.Insert(v.cbegin() + 2, outside);
+        assert(C::copy_ctor == 1 && C::move_ctor == 1 && C::move_assign == NUM - 2);
+        assert(C::copy_assign == 0 && C::dtor == 1);
+
+        // The argument is in the tail, so it is copied before anything moves
+        C::Reset();
+        v.Insert(v.cbegin() + 2, v[5]);
+        assert(C::copy_ctor == 1 && C::move_ctor == 1 && C::move_assign == NUM);
+        assert(C::copy_assign == 0 && C::dtor == 1);
+    }
+    {
+        // Trivially relocatable tails move with one memmove
+        RelocatableObj::ResetCounters();
+        Vector<RelocatableObj> v;
+        v.Reserve(NUM + 2);
+        for (int i = 0; i < static_cast<int>(NUM); ++i) {
+            v.EmplaceBack(i);
+        }
+        v.Emplace(v.cbegin() + 1, -1);
+        assert(RelocatableObj::num_moved == 0 && RelocatableObj::num_destroyed == 0);
+        v.Insert(v.cbegin() + 1, std::move(v[5]));
+        assert(RelocatableObj::num_moved == 1 && RelocatableObj::num_destroyed == 0);
+        assert(*v[0].value == 0 && *v[1].value == 4 && *v[2].value == -1 && *v[3].value == 1);
+        assert(v[6].value == nullptr && *v[11].value == 9);
+    }
+    {
+        // A realloc-grown buffer still sees arguments that refer to its elements
+        Vector<int, MallocAllocator<int>> v(4);
+        std::iota(v.begin(), v.end(), 1);
+        assert(v.Size() == v.Capacity());
+        v.Insert(v.cbegin() + 1, v[3]);
+        v.Emplace(v.cbegin(), 0);
+        assert((v.Size() == 6 && v[0] == 0 && v[1] == 1 && v[2] == 4 && v[3] == 2 && v[5] == 4));
+    }
+}
+
+struct AssignSite {
+};
+
+// Growing assignments keep the old elements and assign over them
+void Test28() {
+    using namespace std::literals;
+    const size_t SMALL = 5;
+    const size_t LARGE = 20;
+    {
+        using Instrumentation = CountingInstrumentation<AssignSite>;
+        Instrumentation::Reset();
+        Vector<Obj, std::allocator<Obj>, DoublingGrowth<>, Instrumentation> small(SMALL);
+        const Vector<Obj, std::allocator<Obj>, DoublingGrowth<>, Instrumentation> large(LARGE);
+        Obj::ResetCounters();
+        small = large;
+        assert(small.Size() == LARGE && small.Capacity() == LARGE);
+        assert(Obj::num_moved == static_cast<int>(SMALL) && Obj::num_assigned == static_cast<int>(SMALL));
+        assert(Obj::num_copied == static_cast<int>(LARGE - SMALL));
+        assert(Obj::num_destroyed == static_cast<int>(SMALL));
+        assert(Instrumentation::GetStats().reallocations == 1);
+    }
+    {
+        // Capacity grows through the growth policy
+        Vector<int> v(SMALL * 3);
+        v.Resize(SMALL);
+        Vector<int> src(LARGE);
+        std::iota(src.begin(), src.end(), 0);
+        v = src;
+        assert(v.Capacity() == SMALL * 6 && v[LARGE - 1] == static_cast<int>(LARGE - 1));
+    }
+    {
+        Vector<std::string> v(SMALL);
+        const std::vector<std::string> words{"a"s, "b"s, "c"s};
+        v.Assign(words.begin(), words.end());
+        assert(v.Size() == 3 && v[0] == "a"s && v[2] == "c"s);
+
+        v.Assign(LARGE, v[1]);
+        assert(v.Size() == LARGE && std::all_of(v.begin(), v.end(), [](const std::string& word) {
+            return word == "b"s;
+        }));
+        v.Assign(2, "x"s);
+        assert(v.Size() == 2 && v[1] == "x"s);
+
+        std::istringstream longer("d e f g");
+        v.Assign(std::istream_iterator<std::string>(longer), std::istream_iterator<std::string>());
+        assert(v.Size() == 4 && v[0] == "d"s && v[3] == "g"s);
+        std::istringstream shorter("h");
+        v.Assign(std::istream_iterator<std::string>(shorter), std::istream_iterator<std::string>());
+        assert(v.Size() == 1 && v[0] == "h"s);
+    }
+}
+
+void Test29() {
+    const size_t NUM = 1000;
+    {
+        // Front insertions never shift the elements
+        C c;
+        C::Reset();
+        {
+            DequeVector<C> v;
+            for (size_t i = 0; i < NUM; ++i) {
+                v.PushFront(c);
+            }
+            assert(v.Size() == NUM && v.FrontCapacity() + NUM + v.BackCapacity() == v.Capacity());
+            assert(C::copy_ctor == NUM && C::move_assign == 0 && C::copy_assign == 0);
+            assert(C::move_ctor < 3 * NUM);
+            while (v.Size() > 1) {
+                v.Erase(v.begin());
+            }
+            assert(C::move_assign == 0);
+        }
+        assert(C::dtor == C::copy_ctor + C::move_ctor);
+    }
+    {
+        // A queue that never holds more than a few elements recenters
+        // instead of growing
+        DequeVector<int> queue;
+        for (int i = 0; i < static_cast<int>(NUM * 10); ++i) {
+            queue.PushBack(i);
+            if (queue.Size() > 3) {
+                assert(queue[0] == i - 3);
+                queue.PopFront();
+            }
+        }
+        assert(queue.Capacity() <= 8 && queue.Size() == 3 && queue[2] == static_cast<int>(NUM * 10 - 1));
+    }
+    {
+        // Mixed operations against std::deque
+        Obj::ResetCounters();
+        {
+            DequeVector<Obj> v;
+            std::deque<int> expected;
+            uint32_t state = 12345;
+            for (int i = 0; i < 3000; ++i) {
+                state = state * 1664525u + 1013904223u;
+                const size_t pos = expected.empty() ? 0 : (state >> 8) % (expected.size() + 1);
+                switch ((state >> 24) % 6) {
+                    case 0:
+                        v.EmplaceFront(i);
+                        expected.push_front(i);
+                        break;
+                    case 1:
+                        v.EmplaceBack(i);
+                        expected.push_back(i);
+                        break;
+                    case 2:
+                        v.Emplace(v.cbegin() + pos, i);
+                        expected.insert(expected.begin() + pos, i);
+                        break;
+                    case 3:
+                        if (pos < expected.size()) {
+                            v.Erase(v.cbegin() + pos);
+                            expected.erase(expected.begin() + pos);
+                        }
+                        break;
+                    case 4:
+                        if (!expected.empty()) {
+                            v.Insert(v.cbegin() + pos, v[expected.size() - 1]);
+                            expected.insert(expected.begin() + pos, expected.back());
+                        }
+                        break;
+                    default: {
+                        const size_t count = std::min<size_t>(3, expected.size() - std::min(pos, expected.size()));
+                        v.Erase(v.cbegin() + pos, v.cbegin() + pos + count);
+                        expected.erase(expected.begin() + pos, expected.begin() + pos + count);
+                        break;
+                    }
+                }
+                assert(v.Size() == expected.size());
+            }
+            assert(std::equal(v.begin(), v.end(), expected.begin(), expected.end(), [](const Obj& obj, int id) {
+                return obj.id == id;
+            }));
+
+            DequeVector<Obj> copy(v);
+            assert(copy.Size() == v.Size() && copy.FrontCapacity() == 0);
+            DequeVector<Obj> moved(std::move(copy));
+            copy = moved;
+            assert(copy.Size() == v.Size() && copy[copy.Size() - 1].id == v[v.Size() - 1].id);
+            v.Clear();
+            v.ReserveFront(10);
+            const Obj* old_data = v.begin();
+            v.PushFront(Obj(1));
+            assert(v.FrontCapacity() >= 9 && v.begin() + 1 == old_data);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+}
+
+// Elements of a SegmentedVector never move, so pointers into it survive growth
+void Test30() {
+    const size_t NUM = 10000;
+    {
+        Obj::ResetCounters();
+        SegmentedVector<Obj, std::allocator<Obj>, 64> v;
+        std::vector<const Obj*> addresses;
+        for (int i = 0; i < static_cast<int>(NUM); ++i) {
+            addresses.push_back(&v.EmplaceBack(i));
+        }
+        assert(v.Size() == NUM && v.Capacity() == (NUM + 63) / 64 * 64);
+        assert(Obj::num_moved == 0 && Obj::num_copied == 0);
+        for (size_t i = 0; i < NUM; ++i) {
+            assert(&v[i] == addresses[i] && v[i].id == static_cast<int>(i));
+        }
+
+        const SegmentedVector<Obj, std::allocator<Obj>, 64> copy(v);
+        auto it = copy.begin() + 100;
+        assert(copy.Size() == NUM && it->id == 100 && it[-1].id == 99 && copy.end() - it == static_cast<int>(NUM - 100));
+
+        v.Resize(100);
+        v.ShrinkToFit();
+        assert(v.Size() == 100 && v.Capacity() == 128 && &v[99] == addresses[99]);
+        v.Clear();
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(NUM));
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        SegmentedVector<int, std::allocator<int>, 16> v;
+        for (int i = 0; i < 1000; ++i) {
+            v.PushBack((i * 7919) % 1000);
+        }
+        std::sort(v.begin(), v.end());
+        assert(std::is_sorted(v.cbegin(), v.cend()));
+        auto pos = std::lower_bound(v.cbegin(), v.cend(), 500);
+        assert(pos.Index() == 500 && *pos == 500);
+        SegmentedVector<int, std::allocator<int>, 16>::const_iterator first = v.begin();
+        assert(first < pos && pos - first == 500);
+
+        const Vector<int> flat = v.Flatten();
+        assert(flat.Size() == v.Size() && std::equal(flat.begin(), flat.end(), v.begin()));
+        v.PopBack();
+        assert(v.Size() == 999 && v[998] == 998);
+    }
+}
+
+struct ArenaSite {
+};
+
+// Vectors drawing from one arena grow in place while their buffer is the
+// arena's newest allocation
+void Test31() {
+    MonotonicArena arena(4096);
+    {
+        using Instrumentation = CountingInstrumentation<ArenaSite>;
+        Instrumentation::Reset();
+        Vector<int, ArenaAllocator<int>, DoublingGrowth<>, Instrumentation> v{ArenaAllocator<int>(arena)};
+        v.PushBack(0);
+        const int* data = v.Data();
+        for (int i = 1; i < 1024; ++i) {
+            v.PushBack(i);
+        }
+        assert(v.Data() == data && v.Capacity() == 1024);
+        assert(arena.UsedBytes() == 1024 * sizeof(int) && arena.ReservedBytes() == 4096);
+        // The first allocation, then ten doublings in place
+        VectorStats stats = Instrumentation::GetStats();
+        assert(stats.reallocations == 11 && stats.relocated_bytes == 0);
+
+        // The block is full: the next growth relocates into a new block
+        v.PushBack(1024);
+        assert(v.Data() != data && v[1000] == 1000 && arena.ReservedBytes() == 4096 + 8192);
+
+        // Another allocation in between stops in-place growth
+        ArenaVector<int> other(3, ArenaAllocator<int>(arena));
+        v.Resize(v.Capacity());
+        data = v.Data();
+        v.PushBack(0);
+        assert(v.Data() != data);
+        stats = Instrumentation::GetStats();
+        assert(stats.relocated_bytes == (1024 + 2048) * sizeof(int));
+    }
+    {
+        ArenaVector<std::string> words{ArenaAllocator<std::string>(arena)};
+        words.PushBack("arena");
+        ArenaVector<std::string> copy(words);
+        assert(copy.GetAllocator() == words.GetAllocator() && copy[0] == "arena");
+        struct alignas(128) Wide {
+            char bytes[128];
+        };
+        ArenaVector<Wide> wide(2, ArenaAllocator<Wide>(arena));
+        assert(IsAligned(wide.Data(), 128));
+    }
+    {
+        // A fill-insert of one of the vector's own elements that grows the
+        // buffer in place reads the value before the tail shifts over it
+        ArenaVector<int> ints{ArenaAllocator<int>(arena)};
+        ints.Reserve(4);
+        for (const int value : {0, 10, 20, 30}) {
+            ints.PushBack(value);
+        }
+        const int* data = ints.Data();
+        ints.Insert(ints.cbegin(), 3, ints[3]);
+        assert(ints.Data() == data);
+        const int expected[] = {30, 30, 30, 0, 10, 20, 30};
+        assert(std::equal(ints.begin(), ints.end(), std::begin(expected), std::end(expected)));
+
+        ArenaVector<std::string> words{ArenaAllocator<std::string>(arena)};
+        words.Reserve(2);
+        words.PushBack("first");
+        words.PushBack("last");
+        words.Insert(words.cbegin() + 1, 2, words[1]);
+        assert(words.Size() == 4 && words[0] == "first" && words[1] == "last" && words[2] == "last");
+    }
+    const size_t used = arena.UsedBytes();
+    assert(used > 0);
+    arena.Release();
+    assert(arena.UsedBytes() == 0 && arena.ReservedBytes() == 0);
+}
+
+struct PacketField {
+    int tag;
+    int length;
+};
+
+constexpr StaticVector<PacketField, 8> MakeFields() {
+    StaticVector<PacketField, 8> fields;
+    for (int i = 0; i < 5; ++i) {
+        fields.EmplaceBack(i, i * 10);
+    }
+    fields.Erase(fields.begin() + 1);
+    fields.Insert(fields.begin(), PacketField{-1, 0});
+    fields.Emplace(fields.end(), fields[0]);
+    fields.PopBack();
+    return fields;
+}
+
+constexpr int SumLengths() {
+    const StaticVector<PacketField, 8> fields = MakeFields();
+    int sum = 0;
+    for (const PacketField& field : fields) {
+        sum += field.length;
+    }
+    return sum;
+}
+
+void Test32() {
+    static_assert(MakeFields().Size() == 5 && MakeFields()[0].tag == -1 && MakeFields()[1].tag == 0);
+    static_assert(MakeFields()[2].tag == 2 && SumLengths() == 20 + 30 + 40);
+    static_assert(sizeof(StaticVector<int, 4>) == 4 * sizeof(int) + sizeof(size_t));
+    static_assert(StaticVector<int, 4>::Capacity() == 4);
+    {
+        constexpr StaticVector<int, 4> keys(3);
+        static_assert(keys.Size() == 3 && keys[2] == 0);
+        StaticVector<int, 4> copy = keys;
+        copy.Resize(1);
+        assert(copy.Size() == 1 && keys.Size() == 3);
+    }
+    {
+        Obj::ResetCounters();
+        StaticVector<Obj, 4> v;
+        v.EmplaceBack(1);
+        v.EmplaceBack(3);
+        v.Emplace(v.cbegin() + 1, 2);
+        v.Insert(v.cbegin(), v[2]);
+        assert(v.Size() == 4 && v[0].id == 3 && v[1].id == 1 && v[2].id == 2 && v[3].id == 3);
+        StaticVector<Obj, 4> copy = v;
+        v.Erase(v.cbegin(), v.cbegin() + 2);
+        assert(v.Size() == 2 && v[0].id == 2 && copy.Size() == 4);
+        copy = v;
+        assert(copy.Size() == 2 && copy[1].id == 3);
+        StaticVector<Obj, 4> moved = std::move(copy);
+        assert(moved.Size() == 2 && Obj::num_moved > 0);
+        v.Clear();
+        assert(Obj::GetAliveObjectCount() == 4);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        const std::string words[] = {"StaticVector", "keeps", "strings", "inline"};
+        const StaticVector<std::string, 4> v(std::begin(words), std::end(words));
+        assert(v.Size() == 4 && v[3] == "inline");
+    }
+}
+
+template <FlatSearch Search>
+void CheckFlatSetLookups() {
+    std::mt19937 gen(17);
+    for (size_t n = 0; n <= 70; ++n) {
+        std::vector<int> keys;
+        for (size_t i = 0; i < n; ++i) {
+            keys.push_back(static_cast<int>(gen() % 200) * 2);
+        }
+        const FlatSet<int, std::less<int>, std::allocator<int>, Search> set(keys.begin(), keys.end());
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        assert(set.Size() == keys.size() && std::equal(set.begin(), set.end(), keys.begin()));
+        for (int key = -1; key <= 401; ++key) {
+            const size_t expected = std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+            assert(static_cast<size_t>(set.LowerBound(key) - set.begin()) == expected);
+            assert(set.Contains(key) == std::binary_search(keys.begin(), keys.end(), key));
+        }
+    }
+}
+
+void Test33() {
+    CheckFlatSetLookups<FlatSearch::BINARY>();
+    CheckFlatSetLookups<FlatSearch::BRANCHLESS>();
+    CheckFlatSetLookups<FlatSearch::EYTZINGER>();
+    {
+        using Config = FlatMap<std::string, int, std::less<std::string>, std::allocator<std::pair<std::string, int>>,
+                               FlatSearch::EYTZINGER>;
+        const std::pair<std::string, int> first_batch[] = {{"timeout", 30}, {"retries", 3}, {"port", 80}, {"retries", 5}};
+        Config config(std::begin(first_batch), std::end(first_batch));
+        assert(config.Size() == 3 && config.begin()->first == "port" && config.Find("retries")->second == 3);
+
+        const std::pair<std::string, int> second_batch[] = {{"verbose", 1}, {"port", 8080}, {"host", 0}};
+        config.Insert(std::begin(second_batch), std::end(second_batch));
+        assert(config.Size() == 5 && config.Find("port")->second == 80 && config.begin()->first == "host");
+        assert(std::is_sorted(config.begin(), config.end()));
+
+        // Keys above the existing ones skip the merge
+        const std::pair<std::string, int> sorted_batch[] = {{"zone", 2}, {"zone", 3}, {"workers", 4}};
+        config.Insert(std::begin(sorted_batch), std::end(sorted_batch));
+        assert(config.Size() == 7 && (config.end() - 1)->first == "zone" && (config.end() - 1)->second == 2);
+
+        config["retries"] = 7;
+        ++config["backlog"];
+        assert(config.Size() == 8 && config.Find("backlog")->second == 1 && config.Find("retries")->second == 7);
+        assert(!config.Insert({"backlog", 9}).second && config.Insert({"mode", 9}).second);
+
+        const std::string stale[] = {"verbose", "host", "missing"};
+        assert(config.EraseKeys(std::begin(stale), std::end(stale)) == 2);
+        assert(config.Erase("port") == 1 && config.Erase("port") == 0);
+        assert(config.EraseIf([](const auto& entry) {
+            return entry.second > 5;
+        }) == 3);
+        assert(config.Size() == 3 && !config.Contains("retries") && config.Contains("workers"));
+        assert(config.Find("zone") == config.end() - 1 && config.Find("absent") == config.end());
+        config.Erase(config.begin(), config.begin() + 2);
+        assert(config.Size() == 1 && config.begin()->first == "zone");
+        config.Clear();
+        assert(config.Size() == 0 && !config.Contains("zone"));
+    }
+    {
+        // A batch whose input fails partway leaves the existing keys sorted
+        // and unique
+        const int keys[] = {3, 1};
+        FlatSet<int> set(std::begin(keys), std::end(keys));
+        std::istringstream input("2 1 4 oops");
+        input.exceptions(std::ios::failbit);
+        try {
+            set.Insert(std::istream_iterator<int>(input), std::istream_iterator<int>());
+            assert(false);
+        } catch (const std::ios::failure&) {
+        }
+        assert(set.Size() == 2 && *set.begin() == 1 && *(set.end() - 1) == 3 && !set.Contains(2));
+    }
+}
+
+#if defined(__unix__)
+// Runs f in a child process and reports whether a failed check aborted it
+template <typename F>
+bool FailsCheck(F f) {
+    std::fflush(nullptr);
+    const pid_t pid = fork();
+    if (pid == 0) {
+        std::freopen("/dev/null", "w", stderr);
+        f();
+        std::_Exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT;
+}
+#endif
+
+void Test34() {
+#if ADVANCED_VECTOR_ANNOTATE_CONTAINERS
+    {
+        Vector<int> v;
+        v.Reserve(16);
+        v.PushBack(1);
+        assert(!__asan_address_is_poisoned(v.Data()) && __asan_address_is_poisoned(v.Data() + 1));
+        v.Resize(16);
+        assert(!__asan_address_is_poisoned(v.Data() + 15));
+        v.Erase(v.cbegin() + 2, v.cend());
+        assert(__asan_address_is_poisoned(v.Data() + 2));
+        v.PushBack(3);
+        assert(!__asan_address_is_poisoned(v.Data() + 2) && __asan_address_is_poisoned(v.Data() + 3));
+
+        Vector<int> moved;
+        moved.Reserve(4);
+        moved = std::move(v);
+        assert(moved.Size() == 3 && __asan_address_is_poisoned(moved.Data() + 3));
+        moved.Clear();
+        assert(__asan_address_is_poisoned(moved.Data()));
+    }
+#endif
+#if ADVANCED_VECTOR_CHECK_LEVEL >= ADVANCED_VECTOR_CHECKS_BOUNDS && defined(__unix__)
+    {
+        Vector<int> v(4);
+        assert(!FailsCheck([&v] {
+            v[3] = 1;
+        }));
+        assert(FailsCheck([&v] {
+            v[4] = 1;
+        }));
+        assert(FailsCheck([&v] {
+            v.Erase(v.cend());
+        }));
+        StaticVector<int, 2> fixed(2);
+        assert(FailsCheck([&fixed] {
+            fixed.PushBack(3);
+        }));
+    }
+#endif
+#if ADVANCED_VECTOR_CHECK_LEVEL >= ADVANCED_VECTOR_CHECKS_FULL && defined(__unix__)
+    {
+        Vector<int> v(4);
+        const auto stale = v.cbegin();
+        v.Reserve(100);
+        assert(FailsCheck([&stale] {
+            static_cast<void>(*stale);
+        }));
+        const auto last = v.end() - 1;
+        v.PopBack();
+        assert(FailsCheck([&last] {
+            static_cast<void>(*last);
+        }));
+
+        // Iterators follow the buffer to the vector it moved to
+        const auto first = v.begin();
+        Vector<int> other(std::move(v));
+        assert(&*first == other.Data() && first == other.begin());
+        assert(FailsCheck([&v, &other] {
+            static_cast<void>(v.begin() == other.begin());
+        }));
+
+        Vector<int>::iterator dangling;
+        {
+            Vector<int> temporary(2);
+            dangling = temporary.begin();
+        }
+        assert(FailsCheck([&dangling] {
+            static_cast<void>(*dangling);
+        }));
+    }
+#endif
+}
+
+// WriteTo and ReadFrom round-trip raw and chunked element types through a
+// file and a stream, reuse the destination's capacity and reject data of
+// another element type or cut short
+void Test35() {
+    struct Settings {
+        int level = 3;
+        double ratio = 0.5;
+    };
+    const size_t SIZE = 300000;
+    Vector<int> ints;
+    for (size_t i = 0; i < SIZE; ++i) {
+        ints.PushBack(static_cast<int>(i * 7));
+    }
+    Vector<std::string> strings;
+    for (size_t i = 0; i < 10000; ++i) {
+        strings.PushBack(std::string(i % 50, 'a' + i % 26));
+    }
+    Vector<std::pair<int, std::string>> pairs;
+    pairs.EmplaceBack(1, "one");
+    pairs.EmplaceBack(2, "");
+    Vector<Vector<int>> nested;
+    nested.EmplaceBack(ints.begin(), ints.begin() + 5);
+    nested.EmplaceBack();
+    Vector<Settings> settings(2);
+    settings[1].ratio = 2.0;
+
+    const std::string path = "vector_io_test.bin";
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    assert(fd >= 0);
+    WriteTo(fd, ints);
+    WriteTo(fd, strings);
+    WriteTo(fd, pairs);
+    WriteTo(fd, nested);
+    WriteTo(fd, settings);
+    WriteTo(fd, Vector<int>());
+    const off_t start = ::lseek(fd, 0, SEEK_SET);
+    assert(start == 0);
+    {
+        Vector<int> read_ints;
+        read_ints.Reserve(SIZE);
+        read_ints.PushBack(-1);
+        const int* buffer = read_ints.Data();
+        ReadFrom(fd, read_ints);
+        assert(read_ints.Size() == SIZE && read_ints.Data() == buffer);
+        assert(std::equal(ints.begin(), ints.end(), read_ints.begin()));
+
+        Vector<std::string> read_strings(3);
+        ReadFrom(fd, read_strings);
+        assert(read_strings.Size() == strings.Size());
+        assert(std::equal(strings.begin(), strings.end(), read_strings.begin()));
+
+        Vector<std::pair<int, std::string>> read_pairs;
+        ReadFrom(fd, read_pairs);
+        assert(read_pairs.Size() == 2 && read_pairs[0].second == "one" && read_pairs[1].first == 2);
+
+        Vector<Vector<int>> read_nested;
+        ReadFrom(fd, read_nested);
+        assert(read_nested.Size() == 2 && read_nested[0].Size() == 5 && read_nested[0][4] == 28);
+        assert(read_nested[1].Size() == 0);
+
+        Vector<Settings> read_settings;
+        ReadFrom(fd, read_settings);
+        assert(read_settings.Size() == 2 && read_settings[0].level == 3 && read_settings[1].ratio == 2.0);
+
+        ReadFrom(fd, read_ints);
+        assert(read_ints.Size() == 0);
+        try {
+            ReadFrom(fd, read_ints);
+            assert(false);
+        } catch (const std::runtime_error&) {
+        }
+    }
+    ::close(fd);
+    std::remove(path.c_str());
+
+    std::stringstream stream;
+    WriteTo(stream, strings);
+    WriteTo(stream, ints);
+    {
+        Vector<std::string> read_strings;
+        ReadFrom(stream, read_strings);
+        assert(read_strings.Size() == strings.Size() && read_strings[9999] == strings[9999]);
+        Vector<double> wrong_type;
+        try {
+            ReadFrom(stream, wrong_type);
+            assert(false);
+        } catch (const std::runtime_error&) {
+        }
+    }
+
+    std::string bytes;
+    {
+        std::ostringstream out;
+        WriteTo(out, strings);
+        bytes = out.str();
+    }
+    std::istringstream truncated(bytes.substr(0, bytes.size() - 1));
+    Vector<std::string> partial(2);
+    try {
+        ReadFrom(truncated, partial);
+        assert(false);
+    } catch (const std::runtime_error&) {
     }
+    assert(partial.Size() == 0);
 }
 
 int main() {
@@ -638,7 +2542,35 @@ int main() {
         Test4();
         Test5();
         Test6();
-        Benchmark();
+        Test7();
+        Test8();
+        Test9();
+        Test10();
+        Test11();
+        Test12();
+        Test13();
+        Test14();
+        Test15();
+        Test16();
+        Test17();
+        Test18();
+        Test19();
+        Test20();
+        Test21();
+        Test22();
+        Test23();
+        Test24();
+        Test25();
+        Test26();
+        Test27();
+        Test28();
+        Test29();
+        Test30();
+        Test31();
+        Test32();
+        Test33();
+        Test34();
+        Test35();
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
     }
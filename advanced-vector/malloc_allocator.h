@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <new>
+
+// Allocator over malloc/realloc/free. Vector detects reallocate() and grows
+// buffers of trivially relocatable elements in place, letting the C runtime
+// extend the block or remap its pages instead of copying them.
+template <typename T>
+struct MallocAllocator {
+    using value_type = T;
+
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "malloc does not guarantee alignment of over-aligned types");
+
+    MallocAllocator() noexcept = default;
+
+    template <typename U>
+    MallocAllocator(const MallocAllocator<U>&) noexcept {
+    }
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(CheckedResult(std::malloc(ByteSize(n))));
+    }
+
+    void deallocate(T* p, size_t) noexcept {
+        std::free(p);
+    }
+
+    T* reallocate(T* p, size_t, size_t new_n) {
+        return static_cast<T*>(CheckedResult(std::realloc(static_cast<void*>(p), ByteSize(new_n))));
+    }
+
+    template <typename U>
+    bool operator==(const MallocAllocator<U>&) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const MallocAllocator<U>&) const noexcept {
+        return false;
+    }
+
+private:
+    static size_t ByteSize(size_t n) {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return n * sizeof(T);
+    }
+
+    static void* CheckedResult(void* p) {
+        if (p == nullptr) {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+};
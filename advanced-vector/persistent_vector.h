@@ -0,0 +1,310 @@
+#pragma once
+
+#include "growth_policy.h"
+#include "vector_checks.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// PersistentVector keeps trivially copyable elements in a memory-mapped file,
+// so opening an existing file makes its elements available immediately,
+// without reading or parsing them. The file starts with a header recording
+// size, capacity, element size and alignment, followed by the elements.
+// POSIX only.
+
+enum class FileMode {
+    READ_ONLY,
+    // Creates the file when it does not exist
+    READ_WRITE,
+};
+
+struct PersistentVectorHeader {
+    static constexpr uint64_t MAGIC = 0x31564150'4b56'4441;  // "ADVKPAV1"
+    static constexpr uint32_t VERSION = 1;
+
+    uint64_t magic;
+    uint32_t version;
+    uint32_t data_offset;
+    uint64_t size;
+    uint64_t capacity;
+    uint64_t element_size;
+    uint64_t alignment;
+};
+
+template <typename T, typename Growth = DoublingGrowth<>>
+class PersistentVector {
+public:
+    static_assert(std::is_trivially_copyable_v<T>, "PersistentVector stores elements as raw bytes");
+
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+    using growth_policy = Growth;
+
+    // Elements start at an offset aligned for T and for cache lines
+    static constexpr size_t DATA_ALIGNMENT = std::max<size_t>(alignof(T), 64);
+    static constexpr size_t DATA_OFFSET =
+        (sizeof(PersistentVectorHeader) + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+
+    PersistentVector(const std::string& path, FileMode mode)
+        : read_only_(mode == FileMode::READ_ONLY)
+    {
+        fd_ = ::open(path.c_str(), read_only_ ? O_RDONLY : O_RDWR | O_CREAT, 0644);
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "open " + path);
+        }
+        try {
+            const size_t file_size = FileSize();
+            if (file_size == 0 && !read_only_) {
+                Truncate(DATA_OFFSET);
+                Map(DATA_OFFSET);
+                *Header() = {PersistentVectorHeader::MAGIC, PersistentVectorHeader::VERSION,
+                             static_cast<uint32_t>(DATA_OFFSET), 0, 0,
+                             sizeof(T), alignof(T)};
+            } else {
+                if (file_size < DATA_OFFSET) {
+                    throw std::runtime_error(path + " is not a PersistentVector file");
+                }
+                Map(file_size);
+                Validate(path, file_size);
+            }
+        } catch (...) {
+            Close();
+            throw;
+        }
+    }
+
+    PersistentVector(const PersistentVector&) = delete;
+    PersistentVector& operator=(const PersistentVector&) = delete;
+
+    PersistentVector(PersistentVector&& other) noexcept
+        : fd_(std::exchange(other.fd_, -1))
+        , mapping_(std::exchange(other.mapping_, nullptr))
+        , mapping_size_(std::exchange(other.mapping_size_, 0))
+        , read_only_(other.read_only_)
+    {
+    }
+
+    PersistentVector& operator=(PersistentVector&& rhs) noexcept {
+        if (this != &rhs) {
+            Close();
+            fd_ = std::exchange(rhs.fd_, -1);
+            mapping_ = std::exchange(rhs.mapping_, nullptr);
+            mapping_size_ = std::exchange(rhs.mapping_size_, 0);
+            read_only_ = rhs.read_only_;
+        }
+        return *this;
+    }
+
+    // Changes reach the file through the shared mapping; call Sync() to wait
+    // until they are on disk
+    ~PersistentVector() {
+        Close();
+    }
+
+    // Elements of a read-only vector are mapped without write access, so it
+    // only offers const access; the mutable accessors throw std::logic_error
+    iterator begin() {
+        CheckWritable();
+        return Data();
+    }
+
+    iterator end() {
+        return begin() + Size();
+    }
+
+    const_iterator begin() const noexcept {
+        return const_cast<PersistentVector&>(*this).Data();
+    }
+
+    const_iterator end() const noexcept {
+        return begin() + Size();
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        ADVANCED_VECTOR_CHECK(index < Size());
+        return begin()[index];
+    }
+
+    T& operator[](size_t index) {
+        CheckWritable();
+        ADVANCED_VECTOR_CHECK(index < Size());
+        return Data()[index];
+    }
+
+    size_t Size() const noexcept {
+        return mapping_ != nullptr ? static_cast<size_t>(Header()->size) : 0;
+    }
+
+    size_t Capacity() const noexcept {
+        return mapping_ != nullptr ? static_cast<size_t>(Header()->capacity) : 0;
+    }
+
+    bool IsReadOnly() const noexcept {
+        return read_only_;
+    }
+
+    // Grows the file and remaps it; pointers into the vector are invalidated
+    void Reserve(size_t new_capacity) {
+        CheckWritable();
+        if (new_capacity <= Capacity()) {
+            return;
+        }
+        const size_t new_file_size = DATA_OFFSET + detail::CheckedGrowth(new_capacity, sizeof(T)) * sizeof(T);
+        // The old mapping stays valid if growing or remapping the file fails
+        Truncate(new_file_size);
+        Remap(new_file_size);
+        Header()->capacity = new_capacity;
+    }
+
+    // New elements are value-initialized
+    void Resize(size_t new_size) {
+        CheckWritable();
+        if (new_size > Capacity()) {
+            Reserve(Growth::NextCapacity(Capacity(), new_size, sizeof(T)));
+        }
+        for (size_t i = Size(); i < new_size; ++i) {
+            new (Data() + i) T();
+        }
+        Header()->size = new_size;
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        CheckWritable();
+        if (Size() == Capacity()) {
+            // Remapping unmaps the old elements, which the arguments may
+            // refer to, so the element is built before growing
+            const T value(std::forward<Args>(args)...);
+            Reserve(Growth::NextCapacity(Capacity(), Size() + 1, sizeof(T)));
+            return Append(value);
+        }
+        return Append(T(std::forward<Args>(args)...));
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PopBack() {
+        CheckWritable();
+        if (Size() > 0) {
+            --Header()->size;
+        }
+    }
+
+    // Blocks until the elements and the header are written to the file
+    void Sync() {
+        if (!read_only_ && mapping_ != nullptr && ::msync(mapping_, mapping_size_, MS_SYNC) != 0) {
+            throw std::system_error(errno, std::generic_category(), "msync");
+        }
+    }
+
+private:
+    int fd_ = -1;
+    void* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+    bool read_only_ = false;
+
+    PersistentVectorHeader* Header() const noexcept {
+        return static_cast<PersistentVectorHeader*>(mapping_);
+    }
+
+    T* Data() noexcept {
+        return std::launder(reinterpret_cast<T*>(static_cast<unsigned char*>(mapping_) + DATA_OFFSET));
+    }
+
+    void CheckWritable() const {
+        if (read_only_) {
+            throw std::logic_error("PersistentVector is opened read-only");
+        }
+    }
+
+    T& Append(const T& value) noexcept {
+        T* elem = new (Data() + Size()) T(value);
+        ++Header()->size;
+        return *elem;
+    }
+
+    void Validate(const std::string& path, size_t file_size) const {
+        const PersistentVectorHeader& header = *Header();
+        if (header.magic != PersistentVectorHeader::MAGIC || header.version != PersistentVectorHeader::VERSION) {
+            throw std::runtime_error(path + " is not a PersistentVector file");
+        }
+        if (header.element_size != sizeof(T) || header.alignment != alignof(T) || header.data_offset != DATA_OFFSET) {
+            throw std::runtime_error(path + " stores elements of a different type");
+        }
+        if (header.size > header.capacity
+            || header.capacity > (file_size - DATA_OFFSET) / sizeof(T)) {
+            throw std::runtime_error(path + " is truncated");
+        }
+    }
+
+    size_t FileSize() const {
+        struct stat st;
+        if (::fstat(fd_, &st) != 0) {
+            throw std::system_error(errno, std::generic_category(), "fstat");
+        }
+        return static_cast<size_t>(st.st_size);
+    }
+
+    void Truncate(size_t file_size) {
+        if (::ftruncate(fd_, static_cast<off_t>(file_size)) != 0) {
+            throw std::system_error(errno, std::generic_category(), "ftruncate");
+        }
+    }
+
+    static void* MapFile(int fd, size_t bytes, bool read_only) {
+        void* p = ::mmap(nullptr, bytes, read_only ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "mmap");
+        }
+        return p;
+    }
+
+    void Map(size_t bytes) {
+        mapping_ = MapFile(fd_, bytes, read_only_);
+        mapping_size_ = bytes;
+    }
+
+    void Remap(size_t bytes) {
+        void* p = MapFile(fd_, bytes, read_only_);
+        ::munmap(mapping_, mapping_size_);
+        mapping_ = p;
+        mapping_size_ = bytes;
+    }
+
+    void Close() noexcept {
+        if (mapping_ != nullptr) {
+            ::munmap(mapping_, mapping_size_);
+            mapping_ = nullptr;
+            mapping_size_ = 0;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+};
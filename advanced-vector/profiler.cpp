@@ -0,0 +1,716 @@
+// Replays Vector workloads under different growth, allocator and relocation
+// policies to pick the best policy per call site.
+//
+//     g++ -std=c++17 -O2 -DNDEBUG profiler.cpp -o profiler
+//     ./profiler [--trace=<file>] [--filter=<substring>] [--repeat=<n>]
+//                [--rank=time|rss|allocs|waste] [--heatmap] [--csv]
+//
+// A trace holds one Vector call per line, prefixed by the call site it was
+// recorded at; every site is replayed against its own vector:
+//     <site> push [n]            n PushBack calls (1 by default)
+//     <site> insert <pos> [n]    one Insert of n elements (1 by default)
+//     <site> erase <pos> [n]     one Erase of n elements (1 by default)
+//     <site> pop [n]             n PopBack calls
+//     <site> reserve <n>
+//     <site> resize <n>
+//     <site> shrink              ShrinkToFit
+//     <site> clear
+// where <pos> is an index (clamped to the size) or front, middle or back.
+// Empty lines and lines starting with # are skipped. Without --trace a few
+// built-in workloads are replayed.
+//
+// Elements are 32-byte records. Policies are named growth/allocator/
+// relocation: growth is doubling, 1.5x, size-class or shrinking (doubling
+// that releases memory); the allocator is std, malloc (realloc), caching,
+// arena or vmem (VirtualMemoryAllocator); relocation is memcpy (the record
+// is marked trivially relocatable) or move. Each policy runs in a forked
+// process, so peak RSS is its own. Reported per site and policy, from the
+// fastest of --repeat runs: wall time, growth of peak RSS, buffer allocations
+// and bytes, reallocations (including in-place growth), relocated bytes,
+// shifted elements, and the peak and mean unused capacity in bytes after
+// each Vector call. --heatmap adds the number of reallocations by new
+// capacity. POSIX only.
+
+#include "arena_allocator.h"
+#include "caching_allocator.h"
+#include "growth_policy.h"
+#include "malloc_allocator.h"
+#include "vector.h"
+#include "virtual_memory_allocator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+// Trace operations
+
+enum class OperationKind {
+    PUSH,
+    INSERT,
+    ERASE,
+    POP,
+    RESERVE,
+    RESIZE,
+    SHRINK,
+    CLEAR,
+};
+
+enum class Anchor {
+    INDEX,
+    FRONT,
+    MIDDLE,
+    BACK,
+};
+
+struct Operation {
+    OperationKind kind;
+    Anchor anchor = Anchor::INDEX;
+    size_t index = 0;
+    size_t count = 1;
+};
+
+struct Workload {
+    std::string site;
+    Vector<Operation> operations;
+};
+
+size_t ResolveIndex(const Operation& op, size_t size) noexcept {
+    switch (op.anchor) {
+        case Anchor::FRONT:
+            return 0;
+        case Anchor::MIDDLE:
+            return size / 2;
+        case Anchor::BACK:
+            return size;
+        case Anchor::INDEX:
+            break;
+    }
+    return std::min(op.index, size);
+}
+
+size_t ParseCount(const std::string& token) {
+    size_t parsed = 0;
+    const unsigned long long value = std::stoull(token, &parsed);
+    if (parsed != token.size()) {
+        throw std::invalid_argument("bad number " + token);
+    }
+    return static_cast<size_t>(value);
+}
+
+Operation ParseOperation(std::istringstream& fields) {
+    const std::pair<std::string_view, OperationKind> kinds[] = {
+        {"push", OperationKind::PUSH},     {"insert", OperationKind::INSERT},   {"erase", OperationKind::ERASE},
+        {"pop", OperationKind::POP},       {"reserve", OperationKind::RESERVE}, {"resize", OperationKind::RESIZE},
+        {"shrink", OperationKind::SHRINK}, {"clear", OperationKind::CLEAR}};
+    std::string name;
+    fields >> name;
+    const auto kind = std::find_if(std::begin(kinds), std::end(kinds), [&name](const auto& entry) {
+        return entry.first == name;
+    });
+    if (kind == std::end(kinds)) {
+        throw std::invalid_argument("unknown operation " + name);
+    }
+    Operation op{kind->second};
+    std::string token;
+    if (op.kind == OperationKind::INSERT || op.kind == OperationKind::ERASE) {
+        if (!(fields >> token)) {
+            throw std::invalid_argument(name + " needs a position");
+        }
+        const std::pair<std::string_view, Anchor> anchors[] = {
+            {"front", Anchor::FRONT}, {"middle", Anchor::MIDDLE}, {"back", Anchor::BACK}};
+        const auto anchor = std::find_if(std::begin(anchors), std::end(anchors), [&token](const auto& entry) {
+            return entry.first == token;
+        });
+        if (anchor != std::end(anchors)) {
+            op.anchor = anchor->second;
+        } else {
+            op.index = ParseCount(token);
+        }
+    }
+    const bool needs_count = op.kind == OperationKind::RESERVE || op.kind == OperationKind::RESIZE;
+    const bool takes_count = needs_count || op.kind == OperationKind::PUSH || op.kind == OperationKind::INSERT
+                             || op.kind == OperationKind::ERASE || op.kind == OperationKind::POP;
+    if (takes_count && fields >> token) {
+        op.count = ParseCount(token);
+    } else if (needs_count) {
+        throw std::invalid_argument(name + " needs a size");
+    }
+    if (fields >> token) {
+        throw std::invalid_argument("unexpected " + token);
+    }
+    return op;
+}
+
+// Groups the operations of a trace by call site, in order of first appearance
+Vector<Workload> ReadTrace(std::istream& input) {
+    Vector<Workload> workloads;
+    std::string line;
+    for (size_t line_number = 1; std::getline(input, line); ++line_number) {
+        std::istringstream fields(line);
+        std::string site;
+        if (!(fields >> site) || site[0] == '#') {
+            continue;
+        }
+        try {
+            const Operation op = ParseOperation(fields);
+            auto workload = std::find_if(workloads.begin(), workloads.end(), [&site](const Workload& w) {
+                return w.site == site;
+            });
+            if (workload == workloads.end()) {
+                workloads.PushBack({site, {}});
+                workload = workloads.end() - 1;
+            }
+            workload->operations.PushBack(op);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("line " + std::to_string(line_number) + ": " + e.what());
+        }
+    }
+    return workloads;
+}
+
+Vector<Workload> BuiltinWorkloads() {
+    Vector<Workload> workloads;
+    const size_t SIZE = 1 << 20;
+    workloads.PushBack({"append", {}});
+    workloads[0].operations.PushBack({OperationKind::PUSH, Anchor::INDEX, 0, SIZE});
+
+    workloads.PushBack({"reserved", {}});
+    workloads[1].operations.PushBack({OperationKind::RESERVE, Anchor::INDEX, 0, SIZE});
+    workloads[1].operations.PushBack({OperationKind::PUSH, Anchor::INDEX, 0, SIZE});
+
+    // A FIFO of a few hundred elements
+    workloads.PushBack({"queue", {}});
+    workloads[2].operations.PushBack({OperationKind::PUSH, Anchor::INDEX, 0, 256});
+    for (size_t i = 0; i < 20000; ++i) {
+        workloads[2].operations.PushBack({OperationKind::PUSH, Anchor::INDEX, 0, 1});
+        workloads[2].operations.PushBack({OperationKind::ERASE, Anchor::FRONT, 0, 1});
+    }
+
+    workloads.PushBack({"middle-insert", {}});
+    for (size_t i = 0; i < 20000; ++i) {
+        workloads[3].operations.PushBack({OperationKind::INSERT, Anchor::MIDDLE, 0, 1});
+    }
+
+    // Batches that fill a buffer and drain it again
+    workloads.PushBack({"churn", {}});
+    for (size_t i = 0; i < 200; ++i) {
+        workloads[4].operations.PushBack({OperationKind::PUSH, Anchor::INDEX, 0, 5000 + i % 7 * 1000});
+        workloads[4].operations.PushBack({OperationKind::POP, Anchor::INDEX, 0, 4900});
+        workloads[4].operations.PushBack({OperationKind::CLEAR});
+    }
+    return workloads;
+}
+
+// Counters of the replay in progress
+
+constexpr size_t HEATMAP_BUCKETS = 64;
+
+struct ReplayResult {
+    double seconds = 0;
+    size_t peak_rss_bytes = 0;
+    size_t allocations = 0;
+    size_t allocated_bytes = 0;
+    size_t reallocations = 0;
+    size_t relocated_bytes = 0;
+    size_t shifted_elements = 0;
+    size_t peak_wasted_bytes = 0;
+    double mean_wasted_bytes = 0;
+    // Reallocations by floor(log2(new capacity in elements))
+    size_t heatmap[HEATMAP_BUCKETS] = {};
+};
+
+ReplayResult counters;
+
+// Hooks Vector's reallocations and shifts into counters
+struct ProfileInstrumentation {
+    static void OnReallocation(size_t, size_t new_capacity, size_t relocated_bytes) noexcept {
+        ++counters.reallocations;
+        counters.relocated_bytes += relocated_bytes;
+        if (new_capacity != 0) {
+            ++counters.heatmap[detail::FloorLog2(new_capacity)];
+        }
+    }
+
+    static void OnElementsShifted(size_t count) noexcept {
+        counters.shifted_elements += count;
+    }
+
+    static void OnSizeChanged(size_t, size_t) noexcept {
+    }
+};
+
+// Counts the buffers Base hands out. reallocate() and expand_in_place() are
+// forwarded only when Base provides them, so Vector keeps its fast paths.
+template <typename Base>
+class ProfiledAllocator : public Base {
+public:
+    using value_type = typename Base::value_type;
+    using T = value_type;
+
+    template <typename U>
+    struct rebind {
+        using other = ProfiledAllocator<typename std::allocator_traits<Base>::template rebind_alloc<U>>;
+    };
+
+    ProfiledAllocator() = default;
+
+    explicit ProfiledAllocator(const Base& base)
+        : Base(base)
+    {
+    }
+
+    T* allocate(size_t n) {
+        ++counters.allocations;
+        counters.allocated_bytes += n * sizeof(T);
+        return Base::allocate(n);
+    }
+
+    template <typename B = Base, typename = decltype(std::declval<B&>().reallocate(nullptr, size_t{}, size_t{}))>
+    T* reallocate(T* p, size_t old_n, size_t new_n) {
+        ++counters.allocations;
+        counters.allocated_bytes += new_n * sizeof(T);
+        return Base::reallocate(p, old_n, new_n);
+    }
+
+    template <typename B = Base, typename = decltype(std::declval<B&>().expand_in_place(nullptr, size_t{}, size_t{}))>
+    bool expand_in_place(T* p, size_t old_n, size_t new_n) noexcept {
+        return Base::expand_in_place(p, old_n, new_n);
+    }
+};
+
+// Element types
+
+enum class Relocation {
+    MEMCPY,
+    MOVE,
+};
+
+// 32 bytes with a user-provided move constructor, so only the
+// is_trivially_relocatable specialization below lets Vector copy bytes
+template <Relocation R>
+struct Record {
+    Record() = default;
+
+    explicit Record(uint64_t key) noexcept
+        : fields{key, key + 1, key + 2, key + 3}
+    {
+    }
+
+    Record(const Record&) = default;
+
+    Record(Record&& other) noexcept
+        : fields{other.fields[0], other.fields[1], other.fields[2], other.fields[3]}
+    {
+    }
+
+    Record& operator=(const Record&) = default;
+    Record& operator=(Record&&) = default;
+
+    uint64_t fields[4] = {};
+};
+
+}  // namespace
+
+template <>
+struct is_trivially_relocatable<Record<Relocation::MEMCPY>> : std::true_type {
+};
+
+namespace {
+
+// Replay
+
+template <typename Alloc>
+Alloc MakeAllocator(MonotonicArena& arena) {
+    if constexpr (std::is_constructible_v<Alloc, MonotonicArena&>) {
+        return Alloc(arena);
+    } else {
+        return Alloc();
+    }
+}
+
+// Performs op, calling after_call after each Vector call it stands for
+template <typename V, typename AfterCall>
+void Apply(V& v, const Operation& op, uint64_t& next_key, AfterCall& after_call) {
+    using T = typename V::value_type;
+    switch (op.kind) {
+        case OperationKind::PUSH:
+            for (size_t i = 0; i < op.count; ++i) {
+                v.PushBack(T(next_key++));
+                after_call();
+            }
+            return;
+        case OperationKind::INSERT:
+            v.Insert(v.cbegin() + ResolveIndex(op, v.Size()), op.count, T(next_key++));
+            break;
+        case OperationKind::ERASE: {
+            const size_t index = std::min(ResolveIndex(op, v.Size()), v.Size());
+            v.Erase(v.cbegin() + index, v.cbegin() + index + std::min(op.count, v.Size() - index));
+            break;
+        }
+        case OperationKind::POP:
+            for (size_t i = 0; i < op.count; ++i) {
+                v.PopBack();
+                after_call();
+            }
+            return;
+        case OperationKind::RESERVE:
+            v.Reserve(op.count);
+            break;
+        case OperationKind::RESIZE:
+            v.Resize(op.count);
+            break;
+        case OperationKind::SHRINK:
+            v.ShrinkToFit();
+            break;
+        case OperationKind::CLEAR:
+            v.Clear();
+            break;
+    }
+    after_call();
+}
+
+// Runs the operations repeat times and keeps the fastest run. The unused
+// capacity is sampled after every Vector call.
+template <typename Alloc, typename Growth>
+ReplayResult Replay(const Vector<Operation>& operations, size_t repeat) {
+    using T = typename Alloc::value_type;
+    using Profiled = ProfiledAllocator<Alloc>;
+    using Clock = std::chrono::steady_clock;
+    ReplayResult best;
+    best.seconds = std::numeric_limits<double>::infinity();
+    for (size_t run = 0; run < repeat; ++run) {
+        counters = {};
+        MonotonicArena arena;
+        size_t wasted_sum = 0;
+        size_t num_calls = 0;
+        const Clock::time_point start = Clock::now();
+        {
+            Vector<T, Profiled, Growth, ProfileInstrumentation> v(Profiled(MakeAllocator<Alloc>(arena)));
+            const auto sample = [&v, &wasted_sum, &num_calls] {
+                const size_t wasted = (v.Capacity() - v.Size()) * sizeof(T);
+                counters.peak_wasted_bytes = std::max(counters.peak_wasted_bytes, wasted);
+                wasted_sum += wasted;
+                ++num_calls;
+            };
+            uint64_t next_key = 0;
+            for (const Operation& op : operations) {
+                Apply(v, op, next_key, sample);
+            }
+        }
+        counters.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        counters.mean_wasted_bytes =
+            num_calls == 0 ? 0.0 : static_cast<double>(wasted_sum) / static_cast<double>(num_calls);
+        if (counters.seconds < best.seconds) {
+            best = counters;
+        }
+    }
+    return best;
+}
+
+size_t PeakRssBytes() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+struct PolicyCase {
+    std::string name;
+    std::function<ReplayResult(const Vector<Operation>&, size_t)> replay;
+};
+
+// Runs one replay in a child process and receives its result through a pipe
+ReplayResult RunIsolated(const PolicyCase& policy, const Vector<Operation>& operations, size_t repeat) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        throw std::runtime_error("pipe failed");
+    }
+    std::fflush(stdout);
+    const pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        throw std::runtime_error("fork failed");
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        const size_t rss_before = PeakRssBytes();
+        ReplayResult result = policy.replay(operations, repeat);
+        result.peak_rss_bytes = PeakRssBytes() - std::min(rss_before, PeakRssBytes());
+        const char* bytes = reinterpret_cast<const char*>(&result);
+        for (size_t written = 0; written < sizeof(result);) {
+            const ssize_t n = write(fds[1], bytes + written, sizeof(result) - written);
+            if (n <= 0) {
+                _exit(1);
+            }
+            written += static_cast<size_t>(n);
+        }
+        _exit(0);
+    }
+    close(fds[1]);
+    ReplayResult result;
+    char* bytes = reinterpret_cast<char*>(&result);
+    size_t received = 0;
+    while (received < sizeof(result)) {
+        const ssize_t n = read(fds[0], bytes + received, sizeof(result) - received);
+        if (n <= 0) {
+            break;
+        }
+        received += static_cast<size_t>(n);
+    }
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (received != sizeof(result) || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        throw std::runtime_error("replay with " + policy.name + " failed");
+    }
+    return result;
+}
+
+// Registry
+
+template <typename T, typename Growth>
+void RegisterForGrowth(Vector<PolicyCase>& cases, const std::string& prefix) {
+    cases.PushBack({prefix + "/std", Replay<std::allocator<T>, Growth>});
+    cases.PushBack({prefix + "/malloc", Replay<MallocAllocator<T>, Growth>});
+    cases.PushBack({prefix + "/caching", Replay<CachingAllocator<T>, Growth>});
+    cases.PushBack({prefix + "/arena", Replay<ArenaAllocator<T>, Growth>});
+    cases.PushBack({prefix + "/vmem", Replay<VirtualMemoryAllocator<T>, Growth>});
+}
+
+template <Relocation R>
+void RegisterForRelocation(Vector<PolicyCase>& cases, std::string_view relocation_name) {
+    using T = Record<R>;
+    const std::string suffix = "/" + std::string(relocation_name);
+    Vector<PolicyCase> for_relocation;
+    RegisterForGrowth<T, DoublingGrowth<>>(for_relocation, "doubling");
+    RegisterForGrowth<T, OneAndHalfGrowth<>>(for_relocation, "1.5x");
+    RegisterForGrowth<T, SizeClassGrowth<>>(for_relocation, "size-class");
+    RegisterForGrowth<T, ShrinkingGrowth<>>(for_relocation, "shrinking");
+    for (PolicyCase& policy : for_relocation) {
+        cases.PushBack({policy.name + suffix, std::move(policy.replay)});
+    }
+}
+
+Vector<PolicyCase> RegisterPolicies() {
+    Vector<PolicyCase> cases;
+    RegisterForRelocation<Relocation::MEMCPY>(cases, "memcpy");
+    RegisterForRelocation<Relocation::MOVE>(cases, "move");
+    return cases;
+}
+
+// Reporting
+
+enum class Rank {
+    TIME,
+    RSS,
+    ALLOCS,
+    WASTE,
+};
+
+struct Options {
+    std::string trace;
+    std::string filter;
+    size_t repeat = 3;
+    Rank rank = Rank::TIME;
+    bool heatmap = false;
+    bool csv = false;
+};
+
+double RankKey(Rank rank, const ReplayResult& result) {
+    switch (rank) {
+        case Rank::TIME:
+            return result.seconds;
+        case Rank::RSS:
+            return static_cast<double>(result.peak_rss_bytes);
+        case Rank::ALLOCS:
+            return static_cast<double>(result.allocations);
+        case Rank::WASTE:
+            return result.mean_wasted_bytes;
+    }
+    return result.seconds;
+}
+
+constexpr double KIB = 1024.0;
+constexpr double MIB = 1024.0 * 1024.0;
+
+void PrintHeader(const Options& options) {
+    if (options.csv) {
+        std::printf("site,policy,ms,peak_rss_bytes,allocs,alloc_bytes,reallocs,relocated_bytes,shifted,"
+                    "peak_waste_bytes,mean_waste_bytes\n");
+    } else {
+        std::printf("%-16s %-26s %10s %12s %8s %10s %8s %12s %12s %12s %12s\n", "Site", "Policy", "ms", "peak-RSS-KiB",
+                    "allocs", "alloc-MiB", "reallocs", "reloc-MiB", "shifted", "peak-waste", "mean-waste");
+    }
+}
+
+void PrintResult(const Options& options, const std::string& site, const std::string& policy,
+                 const ReplayResult& result) {
+    if (options.csv) {
+        std::printf("%s,%s,%.3f,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%.1f\n", site.c_str(), policy.c_str(),
+                    result.seconds * 1e3, result.peak_rss_bytes, result.allocations, result.allocated_bytes,
+                    result.reallocations, result.relocated_bytes, result.shifted_elements, result.peak_wasted_bytes,
+                    result.mean_wasted_bytes);
+    } else {
+        std::printf("%-16s %-26s %10.3f %12.0f %8zu %10.2f %8zu %12.2f %12zu %12zu %12.0f\n", site.c_str(),
+                    policy.c_str(), result.seconds * 1e3, static_cast<double>(result.peak_rss_bytes) / KIB,
+                    result.allocations, static_cast<double>(result.allocated_bytes) / MIB, result.reallocations,
+                    static_cast<double>(result.relocated_bytes) / MIB, result.shifted_elements,
+                    result.peak_wasted_bytes, result.mean_wasted_bytes);
+    }
+    std::fflush(stdout);
+}
+
+// One row per policy, one column per power-of-two capacity that any policy
+// reallocated to; '.' marks no reallocations
+void PrintHeatmap(const std::string& site, const Vector<std::string>& policies, const Vector<ReplayResult>& results) {
+    size_t first = HEATMAP_BUCKETS;
+    size_t last = 0;
+    for (const ReplayResult& result : results) {
+        for (size_t bucket = 0; bucket < HEATMAP_BUCKETS; ++bucket) {
+            if (result.heatmap[bucket] != 0) {
+                first = std::min(first, bucket);
+                last = std::max(last, bucket);
+            }
+        }
+    }
+    if (first > last) {
+        return;
+    }
+    std::printf("\nReallocations of %s by new capacity (2^k elements)\n%-26s", site.c_str(), "k");
+    for (size_t bucket = first; bucket <= last; ++bucket) {
+        std::printf(" %4zu", bucket);
+    }
+    std::printf("\n");
+    for (size_t i = 0; i < results.Size(); ++i) {
+        std::printf("%-26s", policies[i].c_str());
+        for (size_t bucket = first; bucket <= last; ++bucket) {
+            if (results[i].heatmap[bucket] == 0) {
+                std::printf(" %4s", ".");
+            } else {
+                std::printf(" %4zu", results[i].heatmap[bucket]);
+            }
+        }
+        std::printf("\n");
+    }
+    std::printf("\n");
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    using namespace std::literals;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg.substr(0, "--trace="sv.size()) == "--trace="sv) {
+            options.trace = std::string(arg.substr("--trace="sv.size()));
+        } else if (arg.substr(0, "--filter="sv.size()) == "--filter="sv) {
+            options.filter = std::string(arg.substr("--filter="sv.size()));
+        } else if (arg.substr(0, "--repeat="sv.size()) == "--repeat="sv) {
+            options.repeat = std::max<size_t>(std::stoull(std::string(arg.substr("--repeat="sv.size()))), 1);
+        } else if (arg.substr(0, "--rank="sv.size()) == "--rank="sv) {
+            const std::string_view name = arg.substr("--rank="sv.size());
+            const std::pair<std::string_view, Rank> ranks[] = {
+                {"time"sv, Rank::TIME}, {"rss"sv, Rank::RSS}, {"allocs"sv, Rank::ALLOCS}, {"waste"sv, Rank::WASTE}};
+            const auto rank = std::find_if(std::begin(ranks), std::end(ranks), [name](const auto& entry) {
+                return entry.first == name;
+            });
+            if (rank == std::end(ranks)) {
+                std::cerr << "Unknown ranking "sv << name << std::endl;
+                return false;
+            }
+            options.rank = rank->second;
+        } else if (arg == "--heatmap"sv) {
+            options.heatmap = true;
+        } else if (arg == "--csv"sv) {
+            options.csv = true;
+        } else {
+            std::cerr << "Unknown option "sv << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    using namespace std::literals;
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        std::cerr << "Usage: "sv << argv[0]
+                  << " [--trace=<file>] [--filter=<substring>] [--repeat=<n>]"
+                     " [--rank=time|rss|allocs|waste] [--heatmap] [--csv]"sv << std::endl;
+        return 1;
+    }
+
+    Vector<Workload> workloads;
+    try {
+        if (options.trace.empty()) {
+            workloads = BuiltinWorkloads();
+        } else {
+            std::ifstream input(options.trace);
+            if (!input) {
+                std::cerr << "Cannot open "sv << options.trace << std::endl;
+                return 1;
+            }
+            workloads = ReadTrace(input);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << options.trace << ": "sv << e.what() << std::endl;
+        return 1;
+    }
+
+    const Vector<PolicyCase> policies = RegisterPolicies();
+    PrintHeader(options);
+    for (const Workload& workload : workloads) {
+        Vector<std::string> names;
+        Vector<ReplayResult> results;
+        for (const PolicyCase& policy : policies) {
+            if (policy.name.find(options.filter) == std::string::npos) {
+                continue;
+            }
+            try {
+                results.PushBack(RunIsolated(policy, workload.operations, options.repeat));
+            } catch (const std::exception& e) {
+                std::cerr << workload.site << ": "sv << e.what() << std::endl;
+                continue;
+            }
+            names.PushBack(policy.name);
+            PrintResult(options, workload.site, policy.name, results[results.Size() - 1]);
+        }
+        if (results.Size() == 0) {
+            continue;
+        }
+        size_t best = 0;
+        for (size_t i = 1; i < results.Size(); ++i) {
+            if (RankKey(options.rank, results[i]) < RankKey(options.rank, results[best])) {
+                best = i;
+            }
+        }
+        if (options.heatmap && !options.csv) {
+            PrintHeatmap(workload.site, names, results);
+        }
+        if (!options.csv) {
+            std::printf("Best for %s: %s\n\n", workload.site.c_str(), names[best].c_str());
+        }
+    }
+}
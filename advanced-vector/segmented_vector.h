@@ -0,0 +1,398 @@
+#pragma once
+
+#include "vector.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+// Vector made of fixed-size RawMemory chunks of ChunkSize elements. Growth
+// only adds chunks, so elements are never relocated and pointers and
+// references to them stay valid until the element is removed. Element i
+// lives at chunk i >> log2(ChunkSize), offset i & (ChunkSize - 1).
+// Iterators refer to the container and an index, so they also survive
+// growth.
+template <typename T, typename Alloc = std::allocator<T>, size_t ChunkSize = 1024>
+class SegmentedVector {
+public:
+    static_assert(ChunkSize > 0 && (ChunkSize & (ChunkSize - 1)) == 0, "ChunkSize must be a power of two");
+
+    static constexpr size_t CHUNK_SIZE = ChunkSize;
+
+    template <bool IsConst>
+    class BasicIterator {
+    public:
+        using Owner = std::conditional_t<IsConst, const SegmentedVector, SegmentedVector>;
+
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const T*, T*>;
+        using reference = std::conditional_t<IsConst, const T&, T&>;
+
+        BasicIterator() = default;
+
+        BasicIterator(Owner* owner, size_t index) noexcept
+            : owner_(owner)
+            , index_(index)
+        {
+        }
+
+        template <bool OtherConst, typename = std::enable_if_t<IsConst && !OtherConst>>
+        BasicIterator(const BasicIterator<OtherConst>& other) noexcept
+            : owner_(other.owner_)
+            , index_(other.index_)
+        {
+        }
+
+        reference operator*() const noexcept {
+            return (*owner_)[index_];
+        }
+
+        pointer operator->() const noexcept {
+            return &**this;
+        }
+
+        reference operator[](difference_type offset) const noexcept {
+            return (*owner_)[index_ + offset];
+        }
+
+        BasicIterator& operator++() noexcept {
+            ++index_;
+            return *this;
+        }
+
+        BasicIterator operator++(int) noexcept {
+            BasicIterator old = *this;
+            ++index_;
+            return old;
+        }
+
+        BasicIterator& operator--() noexcept {
+            --index_;
+            return *this;
+        }
+
+        BasicIterator operator--(int) noexcept {
+            BasicIterator old = *this;
+            --index_;
+            return old;
+        }
+
+        BasicIterator& operator+=(difference_type offset) noexcept {
+            index_ += offset;
+            return *this;
+        }
+
+        BasicIterator& operator-=(difference_type offset) noexcept {
+            index_ -= offset;
+            return *this;
+        }
+
+        friend BasicIterator operator+(BasicIterator it, difference_type offset) noexcept {
+            return it += offset;
+        }
+
+        friend BasicIterator operator+(difference_type offset, BasicIterator it) noexcept {
+            return it += offset;
+        }
+
+        friend BasicIterator operator-(BasicIterator it, difference_type offset) noexcept {
+            return it -= offset;
+        }
+
+        friend difference_type operator-(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+            ADVANCED_VECTOR_CHECK(lhs.owner_ == rhs.owner_);
+            return static_cast<difference_type>(lhs.index_) - static_cast<difference_type>(rhs.index_);
+        }
+
+        friend bool operator==(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+            ADVANCED_VECTOR_CHECK(lhs.owner_ == rhs.owner_);
+            return lhs.index_ == rhs.index_;
+        }
+
+        friend bool operator!=(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+            return !(lhs == rhs);
+        }
+
+        friend bool operator<(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+            return lhs - rhs < 0;
+        }
+
+        friend bool operator>(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+            return rhs < lhs;
+        }
+
+        friend bool operator<=(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+            return !(rhs < lhs);
+        }
+
+        friend bool operator>=(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+            return !(lhs < rhs);
+        }
+
+        size_t Index() const noexcept {
+            return index_;
+        }
+
+    private:
+        friend class BasicIterator<!IsConst>;
+
+        Owner* owner_ = nullptr;
+        size_t index_ = 0;
+    };
+
+    using value_type = T;
+    using iterator = BasicIterator<false>;
+    using const_iterator = BasicIterator<true>;
+    using allocator_type = Alloc;
+
+    SegmentedVector() = default;
+
+    explicit SegmentedVector(const Alloc& alloc) noexcept
+        : alloc_(alloc)
+    {
+    }
+
+    explicit SegmentedVector(size_t size, const Alloc& alloc = Alloc())
+        : alloc_(alloc)
+    {
+        Resize(size);
+    }
+
+    SegmentedVector(const SegmentedVector& other)
+        : alloc_(std::allocator_traits<Alloc>::select_on_container_copy_construction(other.alloc_))
+    {
+        Reserve(other.size_);
+        try {
+            other.ForEachRange(0, other.size_, [this](const T* data, size_t n) {
+                AppendRange(data, n);
+            });
+        } catch (...) {
+            DestroyRange(0, size_);
+            throw;
+        }
+    }
+
+    SegmentedVector(SegmentedVector&& other) noexcept
+        : alloc_(other.alloc_)
+        , chunks_(std::move(other.chunks_))
+        , size_(std::exchange(other.size_, 0))
+    {
+    }
+
+    ~SegmentedVector() {
+        DestroyRange(0, size_);
+    }
+
+    SegmentedVector& operator=(const SegmentedVector& rhs) {
+        if (this != &rhs) {
+            SegmentedVector copy(rhs);
+            Swap(copy);
+        }
+        return *this;
+    }
+
+    SegmentedVector& operator=(SegmentedVector&& rhs) noexcept {
+        if (this != &rhs) {
+            SegmentedVector moved(std::move(rhs));
+            Swap(moved);
+        }
+        return *this;
+    }
+
+    void Swap(SegmentedVector& other) noexcept {
+        using std::swap;
+        swap(alloc_, other.alloc_);
+        chunks_.Swap(other.chunks_);
+        std::swap(size_, other.size_);
+    }
+
+    iterator begin() noexcept {
+        return {this, 0};
+    }
+
+    iterator end() noexcept {
+        return {this, size_};
+    }
+
+    const_iterator begin() const noexcept {
+        return {this, 0};
+    }
+
+    const_iterator end() const noexcept {
+        return {this, size_};
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<SegmentedVector&>(*this)[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        ADVANCED_VECTOR_CHECK(index < size_);
+        return chunks_[index >> CHUNK_LOG2][index & CHUNK_MASK];
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return chunks_.Size() * ChunkSize;
+    }
+
+    Alloc GetAllocator() const noexcept {
+        return alloc_;
+    }
+
+    // Adds chunks until new_capacity elements fit
+    void Reserve(size_t new_capacity) {
+        detail::CheckedGrowth(new_capacity, sizeof(T));
+        const size_t num_chunks = (new_capacity + ChunkSize - 1) / ChunkSize;
+        if (num_chunks > chunks_.Size()) {
+            chunks_.Reserve(num_chunks);
+            while (chunks_.Size() < num_chunks) {
+                chunks_.EmplaceBack(ChunkSize, alloc_);
+            }
+        }
+    }
+
+    // New elements are value-initialized. If an exception is thrown, the
+    // vector keeps its old size.
+    void Resize(size_t new_size) {
+        if (new_size > size_) {
+            Reserve(new_size);
+            const size_t old_size = size_;
+            try {
+                ForEachRange(old_size, new_size, [this](T* data, size_t n) {
+                    std::uninitialized_value_construct_n(data, n);
+                    size_ += n;
+                });
+            } catch (...) {
+                DestroyRange(old_size, size_);
+                size_ = old_size;
+                throw;
+            }
+        } else {
+            DestroyRange(new_size, size_);
+            size_ = new_size;
+        }
+    }
+
+    // Destroys all elements; the chunks are kept for reuse
+    void Clear() noexcept {
+        DestroyRange(0, size_);
+        size_ = 0;
+    }
+
+    // Frees the chunks no element lives in
+    void ShrinkToFit() {
+        const size_t num_chunks = (size_ + ChunkSize - 1) / ChunkSize;
+        while (chunks_.Size() > num_chunks) {
+            chunks_.PopBack();
+        }
+        chunks_.ShrinkToFit();
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        if (size_ == Capacity()) {
+            chunks_.EmplaceBack(ChunkSize, alloc_);
+        }
+        T* elem = new (&Slot(size_)) T(std::forward<Args>(args)...);
+        ++size_;
+        return *elem;
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    void PopBack() noexcept {
+        if (size_ > 0) {
+            std::destroy_at(&Slot(size_ - 1));
+            --size_;
+        }
+    }
+
+    // Copies the elements into one contiguous Vector, a chunk at a time
+    Vector<T, Alloc> Flatten() const {
+        Vector<T, Alloc> result(alloc_);
+        result.Reserve(size_);
+        ForEachRange(0, size_, [&result](const T* data, size_t n) {
+            result.Append(data, data + n);
+        });
+        return result;
+    }
+
+private:
+    using Chunk = RawMemory<T, Alloc>;
+
+    static constexpr size_t CHUNK_LOG2 = detail::FloorLog2(ChunkSize);
+    static constexpr size_t CHUNK_MASK = ChunkSize - 1;
+
+    Alloc alloc_;
+    Vector<Chunk> chunks_;
+    size_t size_ = 0;
+
+    // Storage of slot index, which may hold no element yet
+    T& Slot(size_t index) noexcept {
+        return chunks_[index >> CHUNK_LOG2][index & CHUNK_MASK];
+    }
+
+    // Calls f(data, n) for the contiguous pieces of slots [first, last)
+    template <typename F>
+    void ForEachRange(size_t first, size_t last, F&& f) {
+        while (first < last) {
+            const size_t n = std::min(last - first, ChunkSize - (first & CHUNK_MASK));
+            f(&Slot(first), n);
+            first += n;
+        }
+    }
+
+    template <typename F>
+    void ForEachRange(size_t first, size_t last, F&& f) const {
+        const_cast<SegmentedVector&>(*this).ForEachRange(first, last, [&f](T* data, size_t n) {
+            f(static_cast<const T*>(data), n);
+        });
+    }
+
+    // Copies n elements to the back; the vector keeps its old size if an
+    // exception is thrown
+    void AppendRange(const T* src, size_t n) {
+        const size_t old_size = size_;
+        try {
+            ForEachRange(size_, size_ + n, [this, &src](T* data, size_t count) {
+                std::uninitialized_copy_n(src, count, data);
+                src += count;
+                size_ += count;
+            });
+        } catch (...) {
+            DestroyRange(old_size, size_);
+            size_ = old_size;
+            throw;
+        }
+    }
+
+    void DestroyRange(size_t first, size_t last) noexcept {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            ForEachRange(first, last, [](T* data, size_t n) {
+                std::destroy_n(data, n);
+            });
+        }
+    }
+};
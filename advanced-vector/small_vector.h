@@ -0,0 +1,265 @@
+#pragma once
+
+#include "vector.h"
+
+// SmallVector keeps up to N elements in an inline buffer and spills to a
+// RawMemory heap buffer only when it outgrows it. It shares Vector's
+// interface, growth policies and element relocation engine.
+template <typename T, size_t N, typename Alloc = std::allocator<T>, typename Growth = DoublingGrowth<>>
+class SmallVector {
+public:
+    static_assert(N > 0, "SmallVector needs room for at least one inline element");
+
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+    using allocator_type = Alloc;
+    using growth_policy = Growth;
+
+    static constexpr size_t INLINE_CAPACITY = N;
+
+    SmallVector() = default;
+
+    explicit SmallVector(const Alloc& alloc) noexcept
+        : heap_(alloc)
+    {
+    }
+
+    explicit SmallVector(size_t size, const Alloc& alloc = Alloc())
+        : heap_(size > N ? Memory(size, alloc) : Memory(alloc))
+    {
+        std::uninitialized_value_construct_n(begin(), size);
+        size_ = size;
+    }
+
+    SmallVector(const SmallVector& other)
+        : heap_(other.size_ > N
+                    ? Memory(other.size_, AllocTraits::select_on_container_copy_construction(other.GetAllocator()))
+                    : Memory(AllocTraits::select_on_container_copy_construction(other.GetAllocator())))
+    {
+        std::uninitialized_copy_n(other.begin(), other.size_, begin());
+        size_ = other.size_;
+    }
+
+    SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        : heap_(other.GetAllocator())
+    {
+        StealOrMoveFrom(other);
+    }
+
+    ~SmallVector() {
+        std::destroy_n(begin(), size_);
+    }
+
+    SmallVector& operator=(const SmallVector& rhs) {
+        if (this != &rhs) {
+            AssignElements(rhs.begin(), rhs.Size());
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& rhs) noexcept(std::is_nothrow_move_constructible_v<T>
+                                                       && std::is_nothrow_move_assignable_v<T>) {
+        if (this == &rhs) {
+            return *this;
+        }
+        if (!rhs.IsInline() && heap_.CanStealFrom(rhs.heap_)) {
+            std::destroy_n(begin(), size_);
+            size_ = 0;
+            heap_ = std::move(rhs.heap_);
+            size_ = std::exchange(rhs.size_, 0);
+        } else {
+            AssignElements(std::make_move_iterator(rhs.begin()), rhs.Size());
+        }
+        return *this;
+    }
+
+    iterator begin() noexcept {
+        return IsInline() ? InlineData() : heap_.GetAddress();
+    }
+
+    iterator end() noexcept {
+        return begin() + size_;
+    }
+
+    const_iterator begin() const noexcept {
+        return const_cast<SmallVector&>(*this).begin();
+    }
+
+    const_iterator end() const noexcept {
+        return begin() + size_;
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<SmallVector&>(*this)[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        ADVANCED_VECTOR_CHECK(index < Size());
+        return begin()[index];
+    }
+
+    // Heap buffers are exchanged in O(1); inline elements have to be moved.
+    // Moving them goes through move assignment, which allocates unless the
+    // allocators let it take over the other heap buffer.
+    void Swap(SmallVector& other) noexcept(std::is_nothrow_move_constructible_v<T>
+                                           && std::is_nothrow_move_assignable_v<T>
+                                           && (AllocTraits::propagate_on_container_move_assignment::value
+                                               || AllocTraits::is_always_equal::value)) {
+        if (!IsInline() && !other.IsInline()) {
+            heap_.Swap(other.heap_);
+            std::swap(size_, other.size_);
+        } else {
+            SmallVector tmp(std::move(other));
+            other = std::move(*this);
+            *this = std::move(tmp);
+        }
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return IsInline() ? N : heap_.Capacity();
+    }
+
+    bool IsInline() const noexcept {
+        return heap_.GetAddress() == nullptr;
+    }
+
+    Alloc GetAllocator() const noexcept {
+        return heap_.GetAllocator();
+    }
+
+    void Reserve(size_t new_capacity) {
+        if (new_capacity <= Capacity()) {
+            return;
+        }
+        Memory new_data(new_capacity, heap_.GetAllocator());
+        detail::RelocateN(begin(), size_, new_data.GetAddress());
+        heap_.Swap(new_data);
+    }
+
+    void Resize(size_t new_size) {
+        if (new_size > Size()) {
+            if (new_size > Capacity()) {
+                Reserve(NextCapacity(new_size));
+            }
+            std::uninitialized_value_construct_n(begin() + Size(), new_size - Size());
+        } else {
+            std::destroy_n(begin() + new_size, Size() - new_size);
+        }
+        size_ = new_size;
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        return *(Emplace(cend(), std::forward<Args>(args)...));
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    void PopBack() {
+        if (Size() > 0) {
+            std::destroy_at(end() - 1);
+            --size_;
+        }
+    }
+
+    template <typename... Args>
+    iterator Emplace(const_iterator pos, Args&&... args) {
+        ADVANCED_VECTOR_CHECK(begin() <= pos && pos <= end());
+        size_t index = std::distance(cbegin(), pos);
+
+        if (Size() == Capacity()) {
+            Memory new_data(NextCapacity(Size() + 1), heap_.GetAllocator());
+            detail::RelocateWithInsertion(begin(), Size(), index, new_data.GetAddress(), std::forward<Args>(args)...);
+            heap_.Swap(new_data);
+        } else {
+            detail::EmplaceShifting(begin(), Size(), index, std::forward<Args>(args)...);
+        }
+
+        ++size_;
+        return begin() + index;
+    }
+
+    iterator Insert(const_iterator pos, const T& value) {
+        return Emplace(pos, value);
+    }
+
+    iterator Insert(const_iterator pos, T&& value) {
+        return Emplace(pos, std::move(value));
+    }
+
+    iterator Erase(const_iterator pos) {
+        ADVANCED_VECTOR_CHECK(begin() <= pos && pos < end());
+        size_t index = std::distance(cbegin(), pos);
+        detail::EraseShifting(begin(), Size(), index);
+        --size_;
+        return begin() + index;
+    }
+
+private:
+    using Memory = RawMemory<T, Alloc>;
+    using AllocTraits = typename Memory::AllocTraits;
+
+    alignas(T) unsigned char inline_buffer_[N * sizeof(T)];
+    Memory heap_;
+    size_t size_ = 0;
+
+    T* InlineData() noexcept {
+        return std::launder(reinterpret_cast<T*>(inline_buffer_));
+    }
+
+    size_t NextCapacity(size_t required) const {
+        return Growth::NextCapacity(Capacity(), required, sizeof(T));
+    }
+
+    // Takes other's heap buffer, or moves its inline elements here
+    void StealOrMoveFrom(SmallVector& other) {
+        if (!other.IsInline()) {
+            heap_ = std::move(other.heap_);
+            size_ = std::exchange(other.size_, 0);
+        } else {
+            std::uninitialized_move_n(other.begin(), other.size_, begin());
+            size_ = other.size_;
+            std::destroy_n(other.begin(), other.size_);
+            other.size_ = 0;
+        }
+    }
+
+    template <typename ForwardIt>
+    void AssignElements(ForwardIt src, size_t n) {
+        if (n > Capacity()) {
+            Memory new_data(n, heap_.GetAllocator());
+            std::uninitialized_copy_n(src, n, new_data.GetAddress());
+            std::destroy_n(begin(), Size());
+            heap_.Swap(new_data);
+        } else {
+            size_t min_size = std::min(n, Size());
+            std::copy_n(src, min_size, begin());
+            std::advance(src, min_size);
+            if (n == min_size) {
+                std::destroy_n(begin() + n, Size() - n);
+            } else {
+                std::uninitialized_copy_n(src, n - Size(), begin() + Size());
+            }
+        }
+        size_ = n;
+    }
+};
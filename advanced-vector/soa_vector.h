@@ -0,0 +1,398 @@
+#pragma once
+
+#include "aligned_allocator.h"
+#include "vector.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Contiguous view of one SoAVector column
+template <typename T>
+class ColumnView {
+public:
+    using value_type = std::remove_const_t<T>;
+    using iterator = T*;
+
+    ColumnView(T* data, size_t size) noexcept
+        : data_(data)
+        , size_(size)
+    {
+    }
+
+    iterator begin() const noexcept {
+        return data_;
+    }
+
+    iterator end() const noexcept {
+        return data_ + size_;
+    }
+
+    T& operator[](size_t index) const noexcept {
+        ADVANCED_VECTOR_CHECK(index < size_);
+        return data_[index];
+    }
+
+    T* Data() const noexcept {
+        return data_;
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+private:
+    T* data_;
+    size_t size_;
+};
+
+// Structure-of-arrays companion of Vector: row i is made of the i-th element
+// of every column, and each field type gets its own contiguous column, so a
+// loop over one field reads only that field. All columns share one
+// allocation and start on a cache line. Operations give the same exception
+// guarantees as their Vector counterparts.
+template <typename... Fields>
+class SoAVector {
+public:
+    static_assert(sizeof...(Fields) > 0, "SoAVector needs at least one column");
+
+    static constexpr size_t NUM_COLUMNS = sizeof...(Fields);
+
+    template <size_t I>
+    using ColumnType = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+    SoAVector() = default;
+
+    explicit SoAVector(size_t size) {
+        Resize(size);
+    }
+
+    SoAVector(const SoAVector& other) {
+        Buffer buffer(other.size_);
+        ForEachColumnTransactional(
+            [&](auto i) {
+                std::uninitialized_copy_n(other.template ColumnData<i>(), other.size_, buffer.template Column<i>());
+            },
+            [&](auto i) {
+                std::destroy_n(buffer.template Column<i>(), other.size_);
+            });
+        buffer_.Swap(buffer);
+        size_ = other.size_;
+    }
+
+    SoAVector(SoAVector&& other) noexcept
+        : buffer_(std::move(other.buffer_))
+        , size_(std::exchange(other.size_, 0))
+    {
+    }
+
+    ~SoAVector() {
+        DestroyRange(0, size_);
+    }
+
+    SoAVector& operator=(const SoAVector& rhs) {
+        if (this != &rhs) {
+            SoAVector copy(rhs);
+            Swap(copy);
+        }
+        return *this;
+    }
+
+    SoAVector& operator=(SoAVector&& rhs) noexcept {
+        if (this != &rhs) {
+            DestroyRange(0, size_);
+            size_ = 0;
+            buffer_ = std::move(rhs.buffer_);
+            size_ = std::exchange(rhs.size_, 0);
+        }
+        return *this;
+    }
+
+    void Swap(SoAVector& other) noexcept {
+        buffer_.Swap(other.buffer_);
+        std::swap(size_, other.size_);
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return buffer_.Capacity();
+    }
+
+    template <size_t I>
+    ColumnView<ColumnType<I>> Column() noexcept {
+        return {ColumnData<I>(), size_};
+    }
+
+    template <size_t I>
+    ColumnView<const ColumnType<I>> Column() const noexcept {
+        return {ColumnData<I>(), size_};
+    }
+
+    template <size_t I>
+    ColumnType<I>& Get(size_t index) noexcept {
+        ADVANCED_VECTOR_CHECK(index < size_);
+        return ColumnData<I>()[index];
+    }
+
+    template <size_t I>
+    const ColumnType<I>& Get(size_t index) const noexcept {
+        ADVANCED_VECTOR_CHECK(index < size_);
+        return ColumnData<I>()[index];
+    }
+
+    // References to the fields of one row
+    std::tuple<Fields&...> operator[](size_t index) noexcept {
+        ADVANCED_VECTOR_CHECK(index < size_);
+        return RowAt(index, std::index_sequence_for<Fields...>{});
+    }
+
+    std::tuple<const Fields&...> operator[](size_t index) const noexcept {
+        ADVANCED_VECTOR_CHECK(index < size_);
+        return const_cast<SoAVector&>(*this).RowAt(index, std::index_sequence_for<Fields...>{});
+    }
+
+    void Reserve(size_t new_capacity) {
+        if (new_capacity <= Capacity()) {
+            return;
+        }
+        Buffer new_buffer(new_capacity);
+        RelocateTo(new_buffer);
+    }
+
+    // New rows are value-initialized
+    void Resize(size_t new_size) {
+        if (new_size > size_) {
+            if (new_size > Capacity()) {
+                Reserve(NextCapacity(new_size));
+            }
+            const size_t count = new_size - size_;
+            ForEachColumnTransactional(
+                [&](auto i) {
+                    std::uninitialized_value_construct_n(ColumnData<i>() + size_, count);
+                },
+                [&](auto i) {
+                    std::destroy_n(ColumnData<i>() + size_, count);
+                });
+        } else {
+            DestroyRange(new_size, size_);
+        }
+        size_ = new_size;
+    }
+
+    // Takes one constructor argument per column
+    template <typename... Args>
+    void EmplaceBack(Args&&... args) {
+        static_assert(sizeof...(Args) == NUM_COLUMNS, "EmplaceBack takes one argument per column");
+        auto arg_tuple = std::forward_as_tuple(std::forward<Args>(args)...);
+        if (size_ == Capacity()) {
+            // The row is constructed before the old rows are relocated, so
+            // arguments referring to elements of this vector stay valid
+            Buffer new_buffer(NextCapacity(size_ + 1));
+            ConstructRow(new_buffer, size_, arg_tuple);
+            try {
+                RelocateTo(new_buffer);
+            } catch (...) {
+                ForEachColumn([&](auto i) {
+                    std::destroy_at(new_buffer.template Column<i>() + size_);
+                });
+                throw;
+            }
+        } else {
+            ConstructRow(buffer_, size_, arg_tuple);
+        }
+        ++size_;
+    }
+
+    void PushBack(const Fields&... fields) {
+        EmplaceBack(fields...);
+    }
+
+    void PopBack() noexcept {
+        if (size_ > 0) {
+            DestroyRange(size_ - 1, size_);
+            --size_;
+        }
+    }
+
+    void Erase(size_t index) {
+        Erase(index, index + 1);
+    }
+
+    // Removes rows [first, last)
+    void Erase(size_t first, size_t last) {
+        ADVANCED_VECTOR_CHECK(first <= last && last <= size_);
+        ForEachColumn([&](auto i) {
+            detail::EraseRangeShifting(ColumnData<i>(), size_, first, last - first);
+        });
+        size_ -= last - first;
+    }
+
+private:
+    static constexpr size_t COLUMN_ALIGNMENT = std::max({CACHE_LINE_SIZE, alignof(Fields)...});
+    static constexpr size_t ROW_SIZE = (sizeof(Fields) + ...);
+
+    struct alignas(COLUMN_ALIGNMENT) Block {
+        unsigned char bytes[COLUMN_ALIGNMENT];
+    };
+
+    // One allocation split into cache-line aligned columns
+    class Buffer {
+    public:
+        Buffer() = default;
+
+        explicit Buffer(size_t capacity)
+            : memory_(BlockCount(capacity))
+            , capacity_(capacity)
+        {
+            unsigned char* base = reinterpret_cast<unsigned char*>(memory_.GetAddress());
+            size_t offset = 0;
+            ForEachColumn([&](auto i) {
+                std::get<i>(columns_) = reinterpret_cast<ColumnType<i>*>(base + offset);
+                offset += ColumnBytes(capacity, sizeof(ColumnType<i>));
+            });
+        }
+
+        Buffer(Buffer&& other) noexcept
+            : memory_(std::move(other.memory_))
+            , columns_(std::exchange(other.columns_, {}))
+            , capacity_(std::exchange(other.capacity_, 0))
+        {
+        }
+
+        Buffer& operator=(Buffer&& rhs) noexcept {
+            memory_ = std::move(rhs.memory_);
+            columns_ = std::exchange(rhs.columns_, {});
+            capacity_ = std::exchange(rhs.capacity_, 0);
+            return *this;
+        }
+
+        void Swap(Buffer& other) noexcept {
+            memory_.Swap(other.memory_);
+            std::swap(columns_, other.columns_);
+            std::swap(capacity_, other.capacity_);
+        }
+
+        template <size_t I>
+        ColumnType<I>* Column() const noexcept {
+            return std::get<I>(columns_);
+        }
+
+        size_t Capacity() const noexcept {
+            return capacity_;
+        }
+
+    private:
+        static size_t ColumnBytes(size_t capacity, size_t element_size) noexcept {
+            return (capacity * element_size + COLUMN_ALIGNMENT - 1) / COLUMN_ALIGNMENT * COLUMN_ALIGNMENT;
+        }
+
+        static size_t BlockCount(size_t capacity) {
+            detail::CheckedGrowth(capacity, ROW_SIZE);
+            return ((ColumnBytes(capacity, sizeof(Fields)) + ...)) / COLUMN_ALIGNMENT;
+        }
+
+        RawMemory<Block> memory_;
+        std::tuple<Fields*...> columns_;
+        size_t capacity_ = 0;
+    };
+
+    Buffer buffer_;
+    size_t size_ = 0;
+
+    template <typename F, size_t... Is>
+    static void ForEachColumnImpl(F& f, std::index_sequence<Is...>) {
+        (f(std::integral_constant<size_t, Is>{}), ...);
+    }
+
+    // Calls f(std::integral_constant<size_t, I>) for every column I
+    template <typename F>
+    static void ForEachColumn(F&& f) {
+        ForEachColumnImpl(f, std::index_sequence_for<Fields...>{});
+    }
+
+    // Applies op to every column; if it throws, undo is applied to the
+    // columns op has already completed
+    template <typename Op, typename Undo>
+    static void ForEachColumnTransactional(Op&& op, Undo&& undo) {
+        size_t done = 0;
+        try {
+            ForEachColumn([&](auto i) {
+                op(i);
+                ++done;
+            });
+        } catch (...) {
+            ForEachColumn([&](auto i) {
+                if (i < done) {
+                    undo(i);
+                }
+            });
+            throw;
+        }
+    }
+
+    template <size_t I>
+    ColumnType<I>* ColumnData() const noexcept {
+        return buffer_.template Column<I>();
+    }
+
+    template <size_t... Is>
+    std::tuple<Fields&...> RowAt(size_t index, std::index_sequence<Is...>) noexcept {
+        return std::tuple<Fields&...>(ColumnData<Is>()[index]...);
+    }
+
+    size_t NextCapacity(size_t required) const {
+        return DoublingGrowth<>::NextCapacity(Capacity(), required, ROW_SIZE);
+    }
+
+    template <typename ArgTuple>
+    static void ConstructRow(Buffer& buffer, size_t index, ArgTuple& args) {
+        ForEachColumnTransactional(
+            [&](auto i) {
+                new (buffer.template Column<i>() + index) ColumnType<i>(std::get<i>(std::move(args)));
+            },
+            [&](auto i) {
+                std::destroy_at(buffer.template Column<i>() + index);
+            });
+    }
+
+    // Moves every column into new_buffer and adopts it. The rows are left
+    // intact if an exception is thrown.
+    void RelocateTo(Buffer& new_buffer) {
+        ForEachColumnTransactional(
+            [&](auto i) {
+                using T = ColumnType<i>;
+                if constexpr (is_trivially_relocatable_v<T>) {
+                    if (size_ != 0) {
+                        std::memcpy(static_cast<void*>(new_buffer.template Column<i>()),
+                                    static_cast<const void*>(ColumnData<i>()), size_ * sizeof(T));
+                    }
+                } else {
+                    detail::UninitializedMoveIfNoexceptN(ColumnData<i>(), size_, new_buffer.template Column<i>());
+                }
+            },
+            [&](auto i) {
+                if constexpr (!is_trivially_relocatable_v<ColumnType<i>>) {
+                    std::destroy_n(new_buffer.template Column<i>(), size_);
+                }
+            });
+        ForEachColumn([&](auto i) {
+            if constexpr (!is_trivially_relocatable_v<ColumnType<i>>) {
+                std::destroy_n(ColumnData<i>(), size_);
+            }
+        });
+        buffer_.Swap(new_buffer);
+    }
+
+    void DestroyRange(size_t first, size_t last) noexcept {
+        ForEachColumn([&](auto i) {
+            std::destroy(ColumnData<i>() + first, ColumnData<i>() + last);
+        });
+    }
+};
@@ -0,0 +1,286 @@
+#pragma once
+
+#include "vector.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace detail {
+
+// Trivial elements live in a plain array, which keeps StaticVector usable in
+// constant expressions; other elements get raw storage and are constructed
+// and destroyed one by one
+template <typename T, size_t N, bool = std::is_trivial_v<T>>
+class StaticVectorStorage {
+protected:
+    static constexpr bool IS_TRIVIAL = true;
+
+    constexpr T* Data() noexcept {
+        return elements_;
+    }
+
+    constexpr const T* Data() const noexcept {
+        return elements_;
+    }
+
+    template <typename... Args>
+    constexpr void ConstructAt(size_t index, Args&&... args) {
+        if constexpr (std::is_constructible_v<T, Args&&...>) {
+            elements_[index] = T(std::forward<Args>(args)...);
+        } else {
+            elements_[index] = T{std::forward<Args>(args)...};
+        }
+    }
+
+    T elements_[N] = {};
+    size_t size_ = 0;
+};
+
+template <typename T, size_t N>
+class StaticVectorStorage<T, N, false> {
+protected:
+    static constexpr bool IS_TRIVIAL = false;
+
+    StaticVectorStorage() noexcept {
+    }
+
+    StaticVectorStorage(const StaticVectorStorage& other) {
+        std::uninitialized_copy_n(other.Data(), other.size_, Data());
+        size_ = other.size_;
+    }
+
+    StaticVectorStorage(StaticVectorStorage&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        std::uninitialized_move_n(other.Data(), other.size_, Data());
+        size_ = other.size_;
+    }
+
+    StaticVectorStorage& operator=(const StaticVectorStorage& rhs) {
+        if (this != &rhs) {
+            Assign(rhs.Data(), rhs.size_);
+        }
+        return *this;
+    }
+
+    StaticVectorStorage& operator=(StaticVectorStorage&& rhs) noexcept(std::is_nothrow_move_constructible_v<T>
+                                                                       && std::is_nothrow_move_assignable_v<T>) {
+        if (this != &rhs) {
+            Assign(std::make_move_iterator(rhs.Data()), rhs.size_);
+        }
+        return *this;
+    }
+
+    ~StaticVectorStorage() {
+        std::destroy_n(Data(), size_);
+    }
+
+    T* Data() noexcept {
+        return std::launder(reinterpret_cast<T*>(bytes_));
+    }
+
+    const T* Data() const noexcept {
+        return std::launder(reinterpret_cast<const T*>(bytes_));
+    }
+
+    template <typename... Args>
+    void ConstructAt(size_t index, Args&&... args) {
+        new (Data() + index) T(std::forward<Args>(args)...);
+    }
+
+    alignas(T) unsigned char bytes_[N * sizeof(T)];
+    size_t size_ = 0;
+
+private:
+    template <typename InputIt>
+    void Assign(InputIt src, size_t n) {
+        const size_t min_size = std::min(n, size_);
+        std::copy_n(src, min_size, Data());
+        if (n < size_) {
+            std::destroy_n(Data() + n, size_ - n);
+        } else {
+            std::uninitialized_copy_n(src + min_size, n - min_size, Data() + size_);
+        }
+        size_ = n;
+    }
+};
+
+}  // namespace detail
+
+// Vector's interface over inline storage for at most N elements; it never
+// allocates. Overflowing the capacity is a contract violation checked by
+// ADVANCED_VECTOR_CHECK, not an exception, so loops over small N can be fully
+// unrolled. For trivial T every operation is constexpr. Moving copies or
+// moves the elements one by one and leaves the source with its size.
+template <typename T, size_t N>
+class StaticVector : private detail::StaticVectorStorage<T, N> {
+    using Storage = detail::StaticVectorStorage<T, N>;
+    using Storage::Data;
+    using Storage::ConstructAt;
+    using Storage::size_;
+    using Storage::IS_TRIVIAL;
+
+public:
+    static_assert(N > 0, "StaticVector needs room for at least one element");
+
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    static constexpr size_t CAPACITY = N;
+
+    constexpr StaticVector() noexcept = default;
+
+    constexpr explicit StaticVector(size_t size) {
+        Resize(size);
+    }
+
+    template <typename InputIt, typename = detail::RequireInputIterator<InputIt>>
+    constexpr StaticVector(InputIt first, InputIt last) {
+        for (; first != last; ++first) {
+            EmplaceBack(*first);
+        }
+    }
+
+    constexpr iterator begin() noexcept {
+        return Data();
+    }
+
+    constexpr iterator end() noexcept {
+        return Data() + size_;
+    }
+
+    constexpr const_iterator begin() const noexcept {
+        return Data();
+    }
+
+    constexpr const_iterator end() const noexcept {
+        return Data() + size_;
+    }
+
+    constexpr const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    constexpr const_iterator cend() const noexcept {
+        return end();
+    }
+
+    constexpr const T& operator[](size_t index) const noexcept {
+        ADVANCED_VECTOR_CHECK(index < size_);
+        return Data()[index];
+    }
+
+    constexpr T& operator[](size_t index) noexcept {
+        ADVANCED_VECTOR_CHECK(index < size_);
+        return Data()[index];
+    }
+
+    constexpr size_t Size() const noexcept {
+        return size_;
+    }
+
+    static constexpr size_t Capacity() noexcept {
+        return N;
+    }
+
+    // New elements are value-initialized
+    constexpr void Resize(size_t new_size) {
+        ADVANCED_VECTOR_CHECK(new_size <= N);
+        if constexpr (IS_TRIVIAL) {
+            for (size_t i = size_; i < new_size; ++i) {
+                Data()[i] = T();
+            }
+        } else if (new_size > size_) {
+            std::uninitialized_value_construct_n(end(), new_size - size_);
+        } else {
+            std::destroy_n(begin() + new_size, size_ - new_size);
+        }
+        size_ = new_size;
+    }
+
+    constexpr void Clear() noexcept {
+        if constexpr (!IS_TRIVIAL) {
+            std::destroy_n(begin(), size_);
+        }
+        size_ = 0;
+    }
+
+    template <typename... Args>
+    constexpr T& EmplaceBack(Args&&... args) {
+        ADVANCED_VECTOR_CHECK(size_ < N);
+        ConstructAt(size_, std::forward<Args>(args)...);
+        return Data()[size_++];
+    }
+
+    constexpr void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    constexpr void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    constexpr void PopBack() noexcept {
+        if (size_ > 0) {
+            --size_;
+            if constexpr (!IS_TRIVIAL) {
+                std::destroy_at(end());
+            }
+        }
+    }
+
+    template <typename... Args>
+    constexpr iterator Emplace(const_iterator pos, Args&&... args) {
+        ADVANCED_VECTOR_CHECK(begin() <= pos && pos <= end());
+        ADVANCED_VECTOR_CHECK(size_ < N);
+        const size_t index = pos - cbegin();
+        if constexpr (IS_TRIVIAL) {
+            // The new value is read before the tail shifts, args may refer to it
+            T value = T();
+            if constexpr (std::is_constructible_v<T, Args&&...>) {
+                value = T(std::forward<Args>(args)...);
+            } else {
+                value = T{std::forward<Args>(args)...};
+            }
+            for (size_t i = size_; i > index; --i) {
+                Data()[i] = Data()[i - 1];
+            }
+            Data()[index] = value;
+        } else {
+            detail::EmplaceShifting(Data(), size_, index, std::forward<Args>(args)...);
+        }
+        ++size_;
+        return begin() + index;
+    }
+
+    constexpr iterator Insert(const_iterator pos, const T& value) {
+        return Emplace(pos, value);
+    }
+
+    constexpr iterator Insert(const_iterator pos, T&& value) {
+        return Emplace(pos, std::move(value));
+    }
+
+    constexpr iterator Erase(const_iterator pos) {
+        ADVANCED_VECTOR_CHECK(begin() <= pos && pos < end());
+        return Erase(pos, pos + 1);
+    }
+
+    constexpr iterator Erase(const_iterator first, const_iterator last) {
+        ADVANCED_VECTOR_CHECK(begin() <= first && first <= last && last <= end());
+        const size_t index = first - cbegin();
+        const size_t count = last - first;
+        if constexpr (IS_TRIVIAL) {
+            for (size_t i = index; i + count < size_; ++i) {
+                Data()[i] = Data()[i + count];
+            }
+        } else {
+            detail::EraseRangeShifting(Data(), size_, index, count);
+        }
+        size_ -= count;
+        return begin() + index;
+    }
+};
@@ -1,36 +1,376 @@
 #pragma once
 
+#include "execution_policy.h"
+#include "growth_policy.h"
+#include "vector_checks.h"
+#include "vector_instrumentation.h"
+
 #include <algorithm>
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
+#include <functional>
 #include <iterator>
 #include <memory>
 #include <new>
+#include <type_traits>
 #include <utility>
 
+// A type is trivially relocatable when moving it to a new address and ending
+// the lifetime of the original is equivalent to copying its bytes. Types that
+// are not trivially copyable may opt in by specializing this trait; types that
+// keep pointers into themselves (e.g. libstdc++ std::string) must not.
+template <typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {
+};
+
+template <typename T, typename Deleter>
+struct is_trivially_relocatable<std::unique_ptr<T, Deleter>> : is_trivially_relocatable<Deleter> {
+};
+
 template <typename T>
-class RawMemory {
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+namespace detail {
+
+template <typename Alloc, typename = void>
+struct HasReallocate : std::false_type {
+};
+
+template <typename Alloc>
+struct HasReallocate<Alloc, std::void_t<decltype(std::declval<Alloc&>().reallocate(
+    std::declval<typename Alloc::value_type*>(), size_t{}, size_t{}))>> : std::true_type {
+};
+
+template <typename Alloc, typename = void>
+struct HasExpandInPlace : std::false_type {
+};
+
+template <typename Alloc>
+struct HasExpandInPlace<Alloc, std::void_t<decltype(std::declval<Alloc&>().expand_in_place(
+    std::declval<typename Alloc::value_type*>(), size_t{}, size_t{}))>> : std::true_type {
+};
+
+template <typename Growth, typename = void>
+struct HasShrinkCapacity : std::false_type {
+};
+
+template <typename Growth>
+struct HasShrinkCapacity<Growth, std::void_t<decltype(Growth::ShrinkCapacity(size_t{}, size_t{}, size_t{}))>>
+    : std::true_type {
+};
+
+// Moves n elements to uninitialized memory at dst, falling back to copies when
+// a throwing move would break the strong exception guarantee
+template <typename T>
+void UninitializedMoveIfNoexceptN(T* src, size_t n, T* dst) {
+    if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
+        std::uninitialized_move_n(src, n, dst);
+    } else {
+        std::uninitialized_copy_n(src, n, dst);
+    }
+}
+
+// Transfers n elements to uninitialized memory at dst and ends the lifetime of
+// the originals. If an exception is thrown the source range is left intact.
+template <typename T>
+void RelocateN(T* src, size_t n, T* dst) {
+    if constexpr (is_trivially_relocatable_v<T>) {
+        if (n != 0) {
+            std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), n * sizeof(T));
+        }
+    } else {
+        UninitializedMoveIfNoexceptN(src, n, dst);
+        std::destroy_n(src, n);
+    }
+}
+
+// Relocates the n elements of src to dst, leaving a gap of gap_size
+// uninitialized slots at position index. src is left intact if an exception
+// is thrown.
+template <typename T>
+void RelocateWithGap(T* src, size_t n, size_t index, T* dst, size_t gap_size) {
+    assert(index <= n);
+    if constexpr (is_trivially_relocatable_v<T>) {
+        RelocateN(src, index, dst);
+        RelocateN(src + index, n - index, dst + index + gap_size);
+    } else {
+        UninitializedMoveIfNoexceptN(src, index, dst);
+        try {
+            UninitializedMoveIfNoexceptN(src + index, n - index, dst + index + gap_size);
+        } catch (...) {
+            std::destroy_n(dst, index);
+            throw;
+        }
+        std::destroy_n(src, n);
+    }
+}
+
+// Constructs an element from args at position index of the uninitialized
+// buffer dst and relocates the n elements of src around it. src is left
+// intact if an exception is thrown.
+template <typename T, typename... Args>
+void RelocateWithInsertion(T* src, size_t n, size_t index, T* dst, Args&&... args) {
+    new (dst + index) T(std::forward<Args>(args)...);
+    try {
+        RelocateWithGap(src, n, index, dst, 1);
+    } catch (...) {
+        std::destroy_at(dst + index);
+        throw;
+    }
+}
+
+// True when one of the objects at ptrs lies in [first, last), e.g. an
+// argument that refers to an element (or a member of one) about to be moved
+template <typename T>
+bool AnyPointsInto(const T*, const T*) noexcept {
+    return false;
+}
+
+template <typename T, typename Ptr, typename... Ptrs>
+bool AnyPointsInto(const T* first, const T* last, const Ptr* ptr, const Ptrs*... ptrs) noexcept {
+    const std::less<const void*> less;
+    return (!less(ptr, first) && less(ptr, last)) || AnyPointsInto(first, last, ptrs...);
+}
+
+// Inserts an element at position index of [data, data + n) when the buffer
+// has room for at least one more element. The element is constructed right
+// in its slot; a temporary is only made when args refer to the shifted tail
+// or, for elements that are not trivially relocatable, when the construction
+// may throw.
+template <typename T, typename... Args>
+void EmplaceShifting(T* data, size_t n, size_t index, Args&&... args) {
+    assert(index <= n);
+    T* pos = data + index;
+    if (index == n) {
+        new (pos) T(std::forward<Args>(args)...);
+        return;
+    }
+    const bool aliased = AnyPointsInto(pos, data + n, std::addressof(args)...);
+    if constexpr (is_trivially_relocatable_v<T>) {
+        const size_t tail_bytes = (n - index) * sizeof(T);
+        if (!aliased) {
+            std::memmove(static_cast<void*>(pos + 1), static_cast<const void*>(pos), tail_bytes);
+            try {
+                new (pos) T(std::forward<Args>(args)...);
+            } catch (...) {
+                std::memmove(static_cast<void*>(pos), static_cast<const void*>(pos + 1), tail_bytes);
+                throw;
+            }
+        } else {
+            // The temporary is relocated into the slot byte-wise, without a
+            // move or a destructor call
+            alignas(T) unsigned char temp_storage[sizeof(T)];
+            T* temp = new (temp_storage) T(std::forward<Args>(args)...);
+            std::memmove(static_cast<void*>(pos + 1), static_cast<const void*>(pos), tail_bytes);
+            std::memcpy(static_cast<void*>(pos), static_cast<const void*>(temp), sizeof(T));
+        }
+    } else {
+        T* last = data + n - 1;
+        if constexpr (std::is_nothrow_constructible_v<T, Args&&...>) {
+            if (!aliased) {
+                new (last + 1) T(std::move(*last));
+                std::move_backward(pos, last, last + 1);
+                std::destroy_at(pos);
+                new (pos) T(std::forward<Args>(args)...);
+                return;
+            }
+        }
+        T temp_obj(std::forward<Args>(args)...);
+        new (last + 1) T(std::move(*last));
+        std::move_backward(pos, last, last + 1);
+        *pos = std::move(temp_obj);
+    }
+}
+
+// Removes count elements starting at position index of [data, data + n),
+// shifting the tail once
+template <typename T>
+void EraseRangeShifting(T* data, size_t n, size_t index, size_t count) {
+    assert(index + count <= n);
+    if constexpr (is_trivially_relocatable_v<T>) {
+        std::destroy_n(data + index, count);
+        if (count != 0) {
+            std::memmove(static_cast<void*>(data + index), static_cast<const void*>(data + index + count),
+                         (n - index - count) * sizeof(T));
+        }
+    } else {
+        std::move(data + index + count, data + n, data + index);
+        std::destroy_n(data + n - count, count);
+    }
+}
+
+// Removes the element at position index of [data, data + n)
+template <typename T>
+void EraseShifting(T* data, size_t n, size_t index) {
+    EraseRangeShifting(data, n, index, 1);
+}
+
+// Moves the elements for which pred is false to the front of [data, data + n)
+// in one pass, destroys the rest and returns the number of kept elements
+template <typename T, typename Predicate>
+size_t CompactIf(T* data, size_t n, Predicate& pred) {
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        // Branchless: every element is copied, the output only advances past
+        // kept ones, which lets the compiler vectorize the loop
+        T* out = data;
+        for (T* it = data; it != data + n; ++it) {
+            const bool keep = !pred(*it);
+            *out = *it;
+            out += keep;
+        }
+        return out - data;
+    } else {
+        T* new_end = std::remove_if(data, data + n, pred);
+        std::destroy(new_end, data + n);
+        return new_end - data;
+    }
+}
+
+constexpr size_t FloorLog2(size_t value) noexcept {
+    assert(value != 0);
+#if defined(__GNUC__)
+    return sizeof(unsigned long long) * 8 - 1 - __builtin_clzll(value);
+#else
+    size_t result = 0;
+    while (value >>= 1) {
+        ++result;
+    }
+    return result;
+#endif
+}
+
+template <typename It>
+using IteratorCategory = typename std::iterator_traits<It>::iterator_category;
+
+template <typename It, typename = void>
+struct IsInputIterator : std::false_type {
+};
+
+template <typename It>
+struct IsInputIterator<It, std::void_t<IteratorCategory<It>>>
+    : std::is_convertible<IteratorCategory<It>, std::input_iterator_tag> {
+};
+
+template <typename It>
+using RequireInputIterator = std::enable_if_t<IsInputIterator<It>::value>;
+
+template <typename It>
+inline constexpr bool IS_FORWARD_ITERATOR = std::is_convertible_v<IteratorCategory<It>, std::forward_iterator_tag>;
+
+template <typename It>
+inline constexpr bool IS_RANDOM_ACCESS_ITERATOR =
+    std::is_convertible_v<IteratorCategory<It>, std::random_access_iterator_tag>;
+
+// Forward iterator yielding the same value, used to feed Insert(pos, n, value)
+// through the range insertion engine
+template <typename T>
+class RepeatIterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    explicit RepeatIterator(const T& value, size_t position = 0) noexcept
+        : value_(&value)
+        , position_(position)
+    {
+    }
+
+    reference operator*() const noexcept {
+        return *value_;
+    }
+
+    pointer operator->() const noexcept {
+        return value_;
+    }
+
+    RepeatIterator& operator++() noexcept {
+        ++position_;
+        return *this;
+    }
+
+    RepeatIterator operator++(int) noexcept {
+        RepeatIterator old = *this;
+        ++position_;
+        return old;
+    }
+
+    bool operator==(const RepeatIterator& other) const noexcept {
+        return position_ == other.position_;
+    }
+
+    bool operator!=(const RepeatIterator& other) const noexcept {
+        return position_ != other.position_;
+    }
+
+private:
+    const T* value_;
+    size_t position_;
+};
+
+}  // namespace detail
+
+// Tag selecting default-initialization: trivial elements are left
+// uninitialized rather than zero-filled
+struct DefaultInitT {
+    explicit DefaultInitT() = default;
+};
+
+inline constexpr DefaultInitT DEFAULT_INIT{};
+
+enum class ClearMode {
+    KEEP_CAPACITY,
+    RELEASE_CAPACITY,
+};
+
+// RawMemory and Vector obtain memory through an allocator, so arena, pool or
+// NUMA-local allocators can be plugged in. Only allocation goes through
+// std::allocator_traits; elements are still constructed in place by Vector.
+template <typename T, typename Alloc = std::allocator<T>>
+class RawMemory : private Alloc {
 public:
+    using allocator_type = Alloc;
+    using AllocTraits = std::allocator_traits<Alloc>;
+
+    static_assert(std::is_same_v<typename AllocTraits::value_type, T>,
+                  "Alloc::value_type must be the same as T");
 
     RawMemory() = default;
 
-    explicit RawMemory(size_t capacity)
-        : buffer_(Allocate(capacity))
+    explicit RawMemory(const Alloc& alloc) noexcept
+        : Alloc(alloc) {
+    }
+
+    explicit RawMemory(size_t capacity, const Alloc& alloc = Alloc())
+        : Alloc(alloc)
+        , buffer_(Allocate(capacity))
         , capacity_(capacity) {
     }
 
     RawMemory(const RawMemory&) = delete;
     RawMemory& operator=(const RawMemory& rhs) = delete;
 
-    RawMemory(RawMemory&& other) noexcept {
-        Deallocate(buffer_);
-        buffer_ = std::exchange(other.buffer_, nullptr);
-        capacity_ = std::exchange(other.capacity_, 0);
+    RawMemory(RawMemory&& other) noexcept
+        : Alloc(std::move(other.GetAllocatorRef()))
+        , buffer_(std::exchange(other.buffer_, nullptr))
+        , capacity_(std::exchange(other.capacity_, 0)) {
     }
-    
+
+    // Stealing the buffer is only valid when it can later be released with
+    // our allocator: Vector falls back to element-wise moves otherwise.
     RawMemory& operator=(RawMemory&& rhs) noexcept {
-        buffer_ = std::exchange(rhs.buffer_, nullptr);
-        capacity_ = std::exchange(rhs.capacity_, 0);            
+        assert(CanStealFrom(rhs));
+        if (this != &rhs) {
+            Deallocate(buffer_);
+            if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+                GetAllocatorRef() = std::move(rhs.GetAllocatorRef());
+            }
+            buffer_ = std::exchange(rhs.buffer_, nullptr);
+            capacity_ = std::exchange(rhs.capacity_, 0);
+        }
         return *this;
     }
 
@@ -39,7 +379,7 @@ public:
     }
 
     T* operator+(size_t offset) noexcept {
-        assert(offset <= capacity_);
+        ADVANCED_VECTOR_CHECK(offset <= capacity_);
         return buffer_ + offset;
     }
 
@@ -52,11 +392,17 @@ public:
     }
 
     T& operator[](size_t index) noexcept {
-        assert(index < capacity_);
+        ADVANCED_VECTOR_CHECK(index < capacity_);
         return buffer_[index];
     }
 
     void Swap(RawMemory& other) noexcept {
+        if constexpr (AllocTraits::propagate_on_container_swap::value) {
+            using std::swap;
+            swap(GetAllocatorRef(), other.GetAllocatorRef());
+        } else {
+            assert(GetAllocatorRef() == other.GetAllocatorRef());
+        }
         std::swap(buffer_, other.buffer_);
         std::swap(capacity_, other.capacity_);
     }
@@ -73,97 +419,226 @@ public:
         return capacity_;
     }
 
+    Alloc GetAllocator() const noexcept {
+        return GetAllocatorRef();
+    }
+
+    static constexpr bool CAN_REALLOCATE = detail::HasReallocate<Alloc>::value;
+
+    // Resizes the buffer through Alloc::reallocate, which may move its bytes.
+    // Only valid for trivially relocatable T.
+    void Reallocate(size_t new_capacity) {
+        static_assert(CAN_REALLOCATE && is_trivially_relocatable_v<T>);
+        if (buffer_ == nullptr) {
+            buffer_ = Allocate(new_capacity);
+        } else {
+            buffer_ = GetAllocatorRef().reallocate(buffer_, capacity_, new_capacity);
+        }
+        capacity_ = new_capacity;
+    }
+
+    static constexpr bool CAN_EXPAND_IN_PLACE = detail::HasExpandInPlace<Alloc>::value;
+
+    // Grows the buffer without moving it when the allocator provides
+    // expand_in_place() and has room after it. Returns false otherwise.
+    bool TryExpand(size_t new_capacity) noexcept {
+        if constexpr (CAN_EXPAND_IN_PLACE) {
+            if (buffer_ != nullptr && GetAllocatorRef().expand_in_place(buffer_, capacity_, new_capacity)) {
+                capacity_ = new_capacity;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Releases the buffer and adopts another allocator
+    void Reset(const Alloc& alloc) noexcept {
+        Deallocate(buffer_);
+        buffer_ = nullptr;
+        capacity_ = 0;
+        GetAllocatorRef() = alloc;
+    }
+
+    bool CanStealFrom(const RawMemory& other) const noexcept {
+        return AllocTraits::propagate_on_container_move_assignment::value
+            || AllocTraits::is_always_equal::value
+            || GetAllocatorRef() == other.GetAllocatorRef();
+    }
+
 private:
-    static T* Allocate(size_t n) {
-        return n != 0 ? static_cast<T*>(operator new(n * sizeof(T))) : nullptr;
+    Alloc& GetAllocatorRef() noexcept {
+        return *this;
     }
 
-    static void Deallocate(T* buf) noexcept {
-        operator delete(buf);
+    const Alloc& GetAllocatorRef() const noexcept {
+        return *this;
+    }
+
+    T* Allocate(size_t n) {
+        return n != 0 ? AllocTraits::allocate(GetAllocatorRef(), n) : nullptr;
+    }
+
+    void Deallocate(T* buf) noexcept {
+        if (buf != nullptr) {
+            AllocTraits::deallocate(GetAllocatorRef(), buf, capacity_);
+        }
     }
 
     T* buffer_ = nullptr;
     size_t capacity_ = 0;
 };
 
-template <typename T>
+template <typename T, typename Alloc = std::allocator<T>, typename Growth = DoublingGrowth<>,
+          typename Instrumentation = NoInstrumentation, typename Execution = SequentialExecution>
 class Vector {
 public:
 
+    using value_type = T;
+#if ADVANCED_VECTOR_CHECK_LEVEL >= ADVANCED_VECTOR_CHECKS_FULL
+    using iterator = detail::CheckedIterator<Vector, T>;
+    using const_iterator = detail::CheckedIterator<Vector, const T>;
+#else
     using iterator = T*;
     using const_iterator = const T*;
+#endif
+    using allocator_type = Alloc;
+    using growth_policy = Growth;
+    using instrumentation = Instrumentation;
+    using execution_policy = Execution;
 
     Vector() = default;
 
-    explicit Vector(size_t size)
-        : data_(size)
+    explicit Vector(const Alloc& alloc) noexcept
+        : data_(alloc)
+    {
+    }
+
+    explicit Vector(size_t size, const Alloc& alloc = Alloc())
+        : data_(size, alloc)
+        , size_(size)
+    {
+        ConstructElements(data_.GetAddress(), size);
+    }
+
+    Vector(size_t size, DefaultInitT, const Alloc& alloc = Alloc())
+        : data_(size, alloc)
         , size_(size)
     {
-        std::uninitialized_value_construct_n(data_.GetAddress(), size);
+        DefaultConstructElements(data_.GetAddress(), size);
+    }
+
+    template <typename InputIt, typename = detail::RequireInputIterator<InputIt>>
+    Vector(InputIt first, InputIt last, const Alloc& alloc = Alloc())
+        : data_(alloc)
+    {
+        Append(first, last);
     }
 
     Vector(const Vector& other)
-        : data_(other.size_)
+        : Vector(other, AllocTraits::select_on_container_copy_construction(other.GetAllocator()))
+    {
+    }
+
+    Vector(const Vector& other, const Alloc& alloc)
+        : data_(other.size_, alloc)
         , size_(other.size_)
     {
-        std::uninitialized_copy_n(other.data_.GetAddress(), other.size_, data_.GetAddress());
+        CopyElements(other.data_.GetAddress(), other.size_, data_.GetAddress());
     }
 
-    Vector(Vector&& other) noexcept {
-        data_ = std::move(other.data_);
-        size_ = std::exchange(other.size_, 0);
+    Vector(Vector&& other) noexcept
+        : data_(std::move(other.data_))
+        , size_(std::exchange(other.size_, 0))
+    {
+        SwapIteratorOwners(other);
+    }
+
+    Vector(Vector&& other, const Alloc& alloc)
+        : data_(alloc)
+    {
+        if (data_.CanStealFrom(other.data_)) {
+            data_ = std::move(other.data_);
+            size_ = std::exchange(other.size_, 0);
+            SwapIteratorOwners(other);
+        } else {
+            Memory new_data(other.size_, alloc);
+            std::uninitialized_move_n(other.Data(), other.size_, new_data.GetAddress());
+            data_.Swap(new_data);
+            size_ = other.size_;
+        }
     }
 
     ~Vector() {
-        std::destroy_n(data_.GetAddress(), size_);
+        DestroyElements(data_.GetAddress(), size_);
+        // The allocator may hand the buffer out again
+        AnnotateSlack(size_, Capacity());
     }
 
     iterator begin() noexcept {
-        return data_.GetAddress();
+        return MakeIterator(data_.GetAddress());
     }
 
     iterator end() noexcept {
-        return data_.GetAddress() + size_;
+        return MakeIterator(data_.GetAddress() + size_);
     }
 
     const_iterator begin() const noexcept {
-        return data_.GetAddress();
+        return MakeIterator(data_.GetAddress());
     }
 
     const_iterator end() const noexcept {
-        return data_.GetAddress() + size_;
+        return MakeIterator(data_.GetAddress() + size_);
     }
 
     const_iterator cbegin() const noexcept {
-        return data_.GetAddress();
+        return begin();
     }
 
     const_iterator cend() const noexcept {
-        return data_.GetAddress() + size_;
+        return end();
+    }
+
+    T* Data() noexcept {
+        return data_.GetAddress();
+    }
+
+    const T* Data() const noexcept {
+        return data_.GetAddress();
     }
 
     Vector& operator=(const Vector& rhs) {
         if (this != &rhs) {
-            if (rhs.Size() > Capacity()) {
-                Vector rhs_copy(rhs);
-                Swap(rhs_copy);
-            } else {                
-                size_t min_size = std::min(rhs.Size(), Size());
-                std::copy_n(rhs.begin(), min_size, begin());
-                if (rhs.Size() == min_size) {
-                    std::destroy_n(begin() + rhs.Size(), Size() - rhs.Size());
-                } else {
-                    std::uninitialized_copy_n(rhs.begin() + Size(), rhs.Size() - Size(), begin() + Size()); 
+            SlackGuard guard(*this);
+            if constexpr (AllocTraits::propagate_on_container_copy_assignment::value
+                          && !AllocTraits::is_always_equal::value) {
+                if (GetAllocator() != rhs.GetAllocator()) {
+                    std::destroy_n(Data(), Size());
+                    size_ = 0;
+                    data_.Reset(rhs.GetAllocator());
                 }
-                size_ = rhs.Size();
             }
+            AssignElements(rhs.Data(), rhs.Size());
         }
         return *this;
     }
 
-    Vector& operator=(Vector&& rhs) noexcept {
-        data_ = std::move(rhs.data_);
-        size_ = std::exchange(rhs.size_, 0);
+    Vector& operator=(Vector&& rhs) noexcept(AllocTraits::propagate_on_container_move_assignment::value
+                                             || AllocTraits::is_always_equal::value) {
+        if (this == &rhs) {
+            return *this;
+        }
+        SlackGuard guard(*this);
+        if (data_.CanStealFrom(rhs.data_)) {
+            // The stolen buffer must enter the guarded state of ours
+            SlackGuard rhs_guard(rhs);
+            std::destroy_n(Data(), Size());
+            size_ = 0;
+            data_ = std::move(rhs.data_);
+            size_ = std::exchange(rhs.size_, 0);
+            SwapIteratorOwners(rhs);
+        } else {
+            AssignElements(std::make_move_iterator(rhs.Data()), rhs.Size());
+        }
         return *this;
     }
 
@@ -172,13 +647,14 @@ public:
     }
 
     T& operator[](size_t index) noexcept {
-        assert(index < Size());
-        return data_[index];
+        ADVANCED_VECTOR_CHECK(index < Size());
+        return data_.GetAddress()[index];
     }
 
     void Swap(Vector& other) noexcept {
         data_.Swap(other.data_);
         std::swap(size_, other.size_);
+        SwapIteratorOwners(other);
     }
 
     size_t Size() const noexcept {
@@ -189,31 +665,106 @@ public:
         return data_.Capacity();
     }
 
+    Alloc GetAllocator() const noexcept {
+        return data_.GetAllocator();
+    }
+
+    // Reserve allocates exactly new_capacity elements, like ReserveExact.
+    // Operations that grow the vector incrementally (EmplaceBack, Resize and
+    // bulk appends) use the growth policy instead.
     void Reserve(size_t new_capacity) {
+        ReserveExact(new_capacity);
+    }
+
+    void ReserveExact(size_t new_capacity) {
         if (new_capacity <= Capacity()) {
             return;
         }
 
-        RawMemory<T> new_data(new_capacity);
-
-        if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
-            std::uninitialized_move_n(begin(), Size(), new_data.GetAddress());
+        SlackGuard guard(*this);
+        const size_t old_capacity = Capacity();
+        if (data_.TryExpand(new_capacity)) {
+            Instrumentation::OnReallocation(old_capacity, new_capacity, 0);
+            return;
+        }
+        if constexpr (CAN_REALLOCATE_IN_PLACE) {
+            data_.Reallocate(new_capacity);
         } else {
-            std::uninitialized_copy_n(begin(), Size(), new_data.GetAddress());
+            Memory new_data(new_capacity, data_.GetAllocator());
+            RelocateElements(Data(), Size(), new_data.GetAddress());
+            data_.Swap(new_data);
         }
+        Instrumentation::OnReallocation(old_capacity, new_capacity, Size() * sizeof(T));
+    }
 
-        std::destroy_n(begin(), Size());
-        data_.Swap(new_data);
+    // Releases the unused capacity; an empty vector gives its buffer back
+    void ShrinkToFit() {
+        if (Capacity() > Size()) {
+            SlackGuard guard(*this);
+            ShrinkTo(Size());
+        }
+    }
+
+    // Destroys all elements. RELEASE_CAPACITY also frees the buffer.
+    void Clear(ClearMode mode = ClearMode::KEEP_CAPACITY) noexcept {
+        SlackGuard guard(*this);
+        DestroyElements(Data(), Size());
+        size_ = 0;
+        if (mode == ClearMode::RELEASE_CAPACITY && Capacity() != 0) {
+            const size_t old_capacity = Capacity();
+            Memory empty(data_.GetAllocator());
+            data_.Swap(empty);
+            Instrumentation::OnReallocation(old_capacity, 0, 0);
+        }
+        Instrumentation::OnSizeChanged(size_, Capacity());
     }
 
     void Resize(size_t new_size) {
+        SlackGuard guard(*this);
+        if (new_size > Size()) {
+            ReserveForGrowth(new_size);
+            ConstructElements(data_.GetAddress() + Size(), new_size - Size());
+        } else {
+            DestroyElements(data_.GetAddress() + new_size, Size() - new_size);
+        }
+        size_ = new_size;
+        MaybeShrink();
+        Instrumentation::OnSizeChanged(size_, Capacity());
+    }
+
+    // Like Resize, but new elements are default-initialized, so trivial
+    // elements keep whatever bytes the buffer held
+    void ResizeDefaultInit(size_t new_size) {
+        SlackGuard guard(*this);
         if (new_size > Size()) {
-            Reserve(new_size);
-            std::uninitialized_value_construct_n(data_.GetAddress() + Size(), new_size - Size());
+            ReserveForGrowth(new_size);
+            DefaultConstructElements(data_.GetAddress() + Size(), new_size - Size());
         } else {
-            std::destroy_n(data_.GetAddress() + new_size, Size() - new_size);
+            DestroyElements(data_.GetAddress() + new_size, Size() - new_size);
+        }
+        size_ = new_size;
+        MaybeShrink();
+        Instrumentation::OnSizeChanged(size_, Capacity());
+    }
+
+    // Makes room for max_size elements and lets op fill the raw storage,
+    // e.g. from read() or recv(). op(T* data, size_t max_size) returns the
+    // number of valid elements, which becomes the new size. Elements past the
+    // old size are uninitialized when op is called. If op throws, the vector
+    // keeps its first min(Size(), max_size) elements.
+    template <typename Operation>
+    void ResizeAndOverwrite(size_t max_size, Operation op) {
+        static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_default_constructible_v<T>,
+                      "ResizeAndOverwrite exposes uninitialized storage and needs trivial T");
+        SlackGuard guard(*this);
+        if (max_size < Size()) {
+            size_ = max_size;
         }
+        ReserveForGrowth(max_size);
+        const size_t new_size = op(data_.GetAddress(), max_size);
+        assert(new_size <= max_size);
         size_ = new_size;
+        Instrumentation::OnSizeChanged(size_, Capacity());
     }
 
     template <typename... Args>
@@ -231,23 +782,26 @@ public:
 
     void PopBack() {
         if (Size() > 0) {
-            std::destroy_at(end() - 1);
+            SlackGuard guard(*this);
+            std::destroy_at(Data() + Size() - 1);
             --size_;
+            MaybeShrink();
         }
     }
 
     template <typename... Args>
     iterator Emplace(const_iterator pos, Args&&... args) {
-        assert(begin() <= pos && pos <= end());
-        size_t index = std::distance(begin(), iterator(pos));
+        const size_t index = PositionIndex(pos);
+        SlackGuard guard(*this);
 
-        if (Size() == Capacity()) {
-            EmplaceWithDataRelocation(pos, index, std::forward<Args>(args)...);
+        if (Size() == Capacity() && !TryExpandForGrowth(Size() + 1)) {
+            EmplaceWithDataRelocation(index, std::forward<Args>(args)...);
         } else {
-            EmplaceWithoutDataRelocation(pos, index, std::forward<Args>(args)...);
+            EmplaceWithoutDataRelocation(index, std::forward<Args>(args)...);
         }
         
         ++size_;
+        Instrumentation::OnSizeChanged(size_, Capacity());
         return begin() + index;
     }
 
@@ -259,46 +813,508 @@ public:
         return Emplace(pos, std::move(value));
     }
 
+    // Inserts count copies of value with a single shift of the tail. value may
+    // refer to an element of this vector.
+    iterator Insert(const_iterator pos, size_t count, const T& value) {
+        const size_t index = PositionIndex(pos);
+        SlackGuard guard(*this);
+        // Growth in place shifts the tail like an insertion within the
+        // capacity, so aliasing is checked rather than inferred from the size
+        if (!detail::AnyPointsInto(Data(), Data() + Size(), std::addressof(value))) {
+            return InsertRange(index, detail::RepeatIterator<T>(value), count);
+        }
+        const T value_copy(value);
+        return InsertRange(index, detail::RepeatIterator<T>(value_copy), count);
+    }
+
+    // Inserts [first, last), reserving at most once and shifting the tail
+    // once for forward iterators. The range must not point into this vector.
+    template <typename InputIt, typename = detail::RequireInputIterator<InputIt>>
+    iterator Insert(const_iterator pos, InputIt first, InputIt last) {
+        const size_t index = PositionIndex(pos);
+        SlackGuard guard(*this);
+        if constexpr (detail::IS_FORWARD_ITERATOR<InputIt>) {
+            return InsertRange(index, first, static_cast<size_t>(std::distance(first, last)));
+        } else {
+            const size_t old_size = Size();
+            for (; first != last; ++first) {
+                EmplaceBack(*first);
+            }
+            Instrumentation::OnElementsShifted(old_size - index);
+            std::rotate(Data() + index, Data() + old_size, Data() + Size());
+            return begin() + index;
+        }
+    }
+
+    template <typename InputIt, typename = detail::RequireInputIterator<InputIt>>
+    void Append(InputIt first, InputIt last) {
+        Insert(cend(), first, last);
+    }
+
+    // Replaces the contents with [first, last), assigning over the existing
+    // elements. The range must not point into this vector.
+    template <typename InputIt, typename = detail::RequireInputIterator<InputIt>>
+    void Assign(InputIt first, InputIt last) {
+        SlackGuard guard(*this);
+        if constexpr (detail::IS_FORWARD_ITERATOR<InputIt>) {
+            AssignElements(first, static_cast<size_t>(std::distance(first, last)));
+        } else {
+            size_t index = 0;
+            for (; index != Size() && first != last; ++index, ++first) {
+                Data()[index] = *first;
+            }
+            if (index != Size()) {
+                Erase(cbegin() + index, cend());
+            } else {
+                Append(first, last);
+            }
+        }
+    }
+
+    // Replaces the contents with n copies of value, which may refer to an
+    // element of this vector
+    void Assign(size_t n, const T& value) {
+        SlackGuard guard(*this);
+        if (detail::AnyPointsInto(Data(), Data() + Size(), &value)) {
+            const T value_copy(value);
+            AssignElements(detail::RepeatIterator<T>(value_copy), n);
+        } else {
+            AssignElements(detail::RepeatIterator<T>(value), n);
+        }
+    }
+
     iterator Erase(const_iterator pos) {
-        assert(begin() <= pos && pos <= end());
-        size_t index = std::distance(begin(), iterator(pos));
-        std::move(std::make_move_iterator(iterator(pos) + 1), std::make_move_iterator(end()), iterator(pos));
-        std::destroy_at(end() - 1);
+        const size_t index = PositionIndex(pos);
+        ADVANCED_VECTOR_CHECK(index < Size());
+        SlackGuard guard(*this);
+        Instrumentation::OnElementsShifted(Size() - index - 1);
+        detail::EraseShifting(Data(), Size(), index);
         --size_;
+        MaybeShrink();
+        return begin() + index;
+    }
+
+    iterator Erase(const_iterator first, const_iterator last) {
+        const size_t index = PositionIndex(first);
+        const size_t last_index = PositionIndex(last);
+        ADVANCED_VECTOR_CHECK(index <= last_index);
+        const size_t count = last_index - index;
+        SlackGuard guard(*this);
+        Instrumentation::OnElementsShifted(Size() - index - count);
+        detail::EraseRangeShifting(Data(), Size(), index, count);
+        size_ -= count;
+        MaybeShrink();
         return begin() + index;
     }
 
+    // Removes every element satisfying pred in a single linear pass and
+    // returns the number of removed elements
+    template <typename Predicate>
+    size_t EraseIf(Predicate pred) {
+        const size_t old_size = Size();
+        SlackGuard guard(*this);
+        size_ = detail::CompactIf(Data(), Size(), pred);
+        MaybeShrink();
+        return old_size - size_;
+    }
+
 private:
-    RawMemory<T> data_;
+    using Memory = RawMemory<T, Alloc>;
+    using AllocTraits = typename Memory::AllocTraits;
+
+    static constexpr bool CAN_REALLOCATE_IN_PLACE = Memory::CAN_REALLOCATE && is_trivially_relocatable_v<T>;
+    static constexpr bool CAN_RELOCATE_WITHOUT_COPIES =
+        is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>;
+
+    Memory data_;
     size_t size_ = 0;
+#if ADVANCED_VECTOR_CHECK_LEVEL >= ADVANCED_VECTOR_CHECKS_FULL
+    detail::IteratorOwner iterator_owner_{this};
+#endif
+#if ADVANCED_VECTOR_ANNOTATE_CONTAINERS
+    unsigned annotation_depth_ = 0;
+#endif
 
-    template <typename... Args>
-    void EmplaceWithDataRelocation(const_iterator pos, size_t index, Args&&... args) {
-        RawMemory<T> new_data(Size() == 0 ? 1 : Size() * 2);
-        new (new_data + index) T(std::forward<Args>(args)...);
+    // Keeps the slack past size_ addressable while a member function that may
+    // build elements there or release the buffer runs. The outermost guard
+    // poisons the slack of whichever buffer the vector holds on exit.
+    class SlackGuard {
+    public:
+        explicit SlackGuard(Vector& vector) noexcept
+            : vector_(vector)
+        {
+#if ADVANCED_VECTOR_ANNOTATE_CONTAINERS
+            if (vector_.annotation_depth_++ == 0) {
+                vector_.AnnotateSlack(vector_.size_, vector_.Capacity());
+            }
+#endif
+        }
+
+        SlackGuard(const SlackGuard&) = delete;
+        SlackGuard& operator=(const SlackGuard&) = delete;
 
-        if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
-            std::uninitialized_move_n(begin(), index, new_data.GetAddress());
-            std::uninitialized_move_n(iterator(pos), Size() - index, new_data.GetAddress() + index + 1);
+        ~SlackGuard() {
+#if ADVANCED_VECTOR_ANNOTATE_CONTAINERS
+            if (--vector_.annotation_depth_ == 0) {
+                vector_.AnnotateSlack(vector_.Capacity(), vector_.size_);
+            }
+#endif
+        }
+
+    private:
+        [[maybe_unused]] Vector& vector_;
+    };
+
+    void AnnotateSlack(size_t old_size, size_t new_size) const noexcept {
+        detail::AnnotateContiguousContainer(data_.GetAddress(), Capacity(), old_size, new_size,
+                                            std::is_same_v<Alloc, std::allocator<T>>);
+    }
+
+    iterator MakeIterator(T* ptr) noexcept {
+#if ADVANCED_VECTOR_CHECK_LEVEL >= ADVANCED_VECTOR_CHECKS_FULL
+        return iterator(ptr, *this, iterator_owner_.GetState());
+#else
+        return ptr;
+#endif
+    }
+
+    const_iterator MakeIterator(const T* ptr) const noexcept {
+#if ADVANCED_VECTOR_CHECK_LEVEL >= ADVANCED_VECTOR_CHECKS_FULL
+        return const_iterator(ptr, *this, iterator_owner_.GetState());
+#else
+        return ptr;
+#endif
+    }
+
+    // Index of pos, which must be an iterator of this vector in
+    // [begin(), end()]
+    size_t PositionIndex(const_iterator pos) const noexcept {
+#if ADVANCED_VECTOR_CHECK_LEVEL >= ADVANCED_VECTOR_CHECKS_FULL
+        const T* ptr = pos.Base(*this);
+#else
+        const T* ptr = pos;
+#endif
+        ADVANCED_VECTOR_CHECK(Data() <= ptr && ptr <= Data() + Size());
+        return ptr - Data();
+    }
+
+    // Iterators follow the buffer when it moves to another vector
+    void SwapIteratorOwners([[maybe_unused]] Vector& other) noexcept {
+#if ADVANCED_VECTOR_CHECK_LEVEL >= ADVANCED_VECTOR_CHECKS_FULL
+        iterator_owner_.Swap(other.iterator_owner_);
+#endif
+    }
+
+    size_t NextCapacity(size_t required) const {
+        return Growth::NextCapacity(Capacity(), required, sizeof(T));
+    }
+
+    // Grows the buffer in place, without relocating elements, if the allocator
+    // supports it
+    bool TryExpandForGrowth(size_t required) {
+        if constexpr (Memory::CAN_EXPAND_IN_PLACE) {
+            const size_t old_capacity = Capacity();
+            const size_t new_capacity = NextCapacity(required);
+            if (data_.TryExpand(new_capacity)) {
+                Instrumentation::OnReallocation(old_capacity, new_capacity, 0);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Moves the elements into a buffer of exactly new_capacity >= Size()
+    // elements, through the same fast paths as ReserveExact
+    void ShrinkTo(size_t new_capacity) {
+        assert(Size() <= new_capacity && new_capacity < Capacity());
+        const size_t old_capacity = Capacity();
+        if (new_capacity == 0) {
+            Memory empty(data_.GetAllocator());
+            data_.Swap(empty);
+        } else if constexpr (CAN_REALLOCATE_IN_PLACE) {
+            data_.Reallocate(new_capacity);
+        } else {
+            Memory new_data(new_capacity, data_.GetAllocator());
+            RelocateElements(Data(), Size(), new_data.GetAddress());
+            data_.Swap(new_data);
+        }
+        Instrumentation::OnReallocation(old_capacity, new_capacity, Size() * sizeof(T));
+    }
+
+    // Shrinks the buffer after elements were removed when the growth policy
+    // provides ShrinkCapacity. Elements whose relocation may throw are never
+    // moved here, and an allocator that throws, whatever the exception, just
+    // leaves the old buffer in place.
+    void MaybeShrink() noexcept {
+        if constexpr (detail::HasShrinkCapacity<Growth>::value &&
+                      (is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible_v<T>)) {
+            const size_t new_capacity = std::max(Growth::ShrinkCapacity(Capacity(), Size(), sizeof(T)), Size());
+            if (new_capacity < Capacity()) {
+                try {
+                    ShrinkTo(new_capacity);
+                } catch (...) {
+                }
+            }
+        }
+    }
+
+    // Makes room for `required` elements with amortized growth
+    void ReserveForGrowth(size_t required) {
+        if (required > Capacity()) {
+            ReserveExact(NextCapacity(required));
+        }
+    }
+
+    // Inserts n elements read from src at position index. Growth builds the
+    // new elements straight into the new buffer; otherwise trivially
+    // relocatable tails are moved with one memmove.
+    template <typename ForwardIt>
+    iterator InsertRange(size_t index, ForwardIt src, size_t n) {
+        if (n == 0) {
+            return begin() + index;
+        }
+
+        if (n > Capacity() - Size() && !TryExpandForGrowth(Size() + n)) {
+            const size_t old_capacity = Capacity();
+            Memory new_data(NextCapacity(Size() + n), data_.GetAllocator());
+            T* gap = new_data.GetAddress() + index;
+            std::uninitialized_copy_n(src, n, gap);
+            try {
+                RelocateWithGap(Data(), Size(), index, new_data.GetAddress(), n);
+            } catch (...) {
+                std::destroy_n(gap, n);
+                throw;
+            }
+            data_.Swap(new_data);
+            Instrumentation::OnReallocation(old_capacity, Capacity(), Size() * sizeof(T));
+            size_ += n;
+        } else if constexpr (is_trivially_relocatable_v<T>) {
+            Instrumentation::OnElementsShifted(Size() - index);
+            T* pos = Data() + index;
+            const size_t tail_bytes = (Size() - index) * sizeof(T);
+            std::memmove(static_cast<void*>(pos + n), static_cast<const void*>(pos), tail_bytes);
+            try {
+                std::uninitialized_copy_n(src, n, pos);
+            } catch (...) {
+                std::memmove(static_cast<void*>(pos), static_cast<const void*>(pos + n), tail_bytes);
+                throw;
+            }
+            size_ += n;
+        } else {
+            Instrumentation::OnElementsShifted(Size() - index);
+            T* pos = Data() + index;
+            T* old_end = Data() + Size();
+            const size_t elems_after = Size() - index;
+            if (elems_after > n) {
+                std::uninitialized_move(old_end - n, old_end, old_end);
+                size_ += n;
+                std::move_backward(pos, old_end - n, old_end);
+                std::copy_n(src, n, pos);
+            } else {
+                ForwardIt mid = src;
+                std::advance(mid, elems_after);
+                std::uninitialized_copy_n(mid, n - elems_after, old_end);
+                try {
+                    std::uninitialized_move(pos, old_end, old_end + (n - elems_after));
+                } catch (...) {
+                    std::destroy_n(old_end, n - elems_after);
+                    throw;
+                }
+                size_ += n;
+                std::copy_n(src, elems_after, pos);
+            }
+        }
+        Instrumentation::OnSizeChanged(size_, Capacity());
+        return begin() + index;
+    }
+
+    // Replaces the contents with n elements read from src, reusing the
+    // already constructed elements by assignment. A growing vector moves them
+    // into a buffer sized by the growth policy first, unless T is trivially
+    // copyable (the copy is then a single memcpy) or relocation would copy.
+    template <typename ForwardIt>
+    void AssignElements(ForwardIt src, size_t n) {
+        if (n > Capacity()) {
+            const size_t old_capacity = Capacity();
+            Memory new_data(NextCapacity(n), data_.GetAllocator());
+            if constexpr (std::is_trivially_copyable_v<T> || !CAN_RELOCATE_WITHOUT_COPIES) {
+                CopyElements(src, n, new_data.GetAddress());
+                DestroyElements(Data(), Size());
+                data_.Swap(new_data);
+                Instrumentation::OnReallocation(old_capacity, Capacity(), 0);
+                size_ = n;
+                Instrumentation::OnSizeChanged(size_, Capacity());
+                return;
+            }
+            RelocateElements(Data(), Size(), new_data.GetAddress());
+            data_.Swap(new_data);
+            Instrumentation::OnReallocation(old_capacity, Capacity(), Size() * sizeof(T));
+        }
+        size_t min_size = std::min(n, Size());
+        AssignElementsInPlace(src, min_size, Data());
+        std::advance(src, min_size);
+        if (n == min_size) {
+            DestroyElements(Data() + n, Size() - n);
         } else {
-            std::uninitialized_copy_n(begin(), index, new_data.GetAddress());
-            std::uninitialized_copy_n(iterator(pos), Size() - index, new_data.GetAddress() + index + 1);
+            CopyElements(src, n - Size(), Data() + Size());
         }
+        size_ = n;
+        Instrumentation::OnSizeChanged(size_, Capacity());
+    }
+
+    template <typename... Args>
+    void EmplaceWithDataRelocation(size_t index, Args&&... args) {
+        const size_t old_capacity = Capacity();
+        const size_t new_capacity = NextCapacity(Size() + 1);
 
-        std::destroy_n(begin(), Size());
-        data_.Swap(new_data);
+        if constexpr (CAN_REALLOCATE_IN_PLACE) {
+            // args referring to elements of this vector are consumed before
+            // the buffer is reallocated, any others construct the element in place
+            if (detail::AnyPointsInto(Data(), Data() + Size(), std::addressof(args)...)) {
+                T temp_obj(std::forward<Args>(args)...);
+                EmplaceWithDataRelocation(index, std::move(temp_obj));
+                return;
+            }
+            data_.Reallocate(new_capacity);
+            Instrumentation::OnReallocation(old_capacity, new_capacity, Size() * sizeof(T));
+            detail::EmplaceShifting(Data(), Size(), index, std::forward<Args>(args)...);
+        } else {
+            Memory new_data(new_capacity, data_.GetAllocator());
+            T* slot = new (new_data + index) T(std::forward<Args>(args)...);
+            try {
+                RelocateWithGap(Data(), Size(), index, new_data.GetAddress(), 1);
+            } catch (...) {
+                std::destroy_at(slot);
+                throw;
+            }
+            data_.Swap(new_data);
+            Instrumentation::OnReallocation(old_capacity, new_capacity, Size() * sizeof(T));
+        }
     }
 
     template <typename... Args>
-    void EmplaceWithoutDataRelocation(const_iterator pos, size_t index, Args&&... args) {
-        if (end() != pos) {
-            T temp_obj(std::forward<Args>(args)...);
-            new (data_ + size_) T(std::forward<T>(*(end() - 1)));
-            std::move_backward(iterator(pos), end() - 1, end()); 
-            data_[index] = std::forward<T>(temp_obj);
+    void EmplaceWithoutDataRelocation(size_t index, Args&&... args) {
+        Instrumentation::OnElementsShifted(Size() - index);
+        detail::EmplaceShifting(Data(), Size(), index, std::forward<Args>(args)...);
+    }
+
+    // Bulk element operations, split into chunks by the execution policy.
+    // The construction helpers leave no element behind when they throw.
+
+    static void ConstructElements(T* dst, size_t n) {
+        // Only an empty request may come without a buffer. Saying so lets
+        // GCC prove the fill below stays inside it (-Warray-bounds).
+        if (dst == nullptr || n == 0) {
+            return;
+        }
+        Execution::Transact(
+            n,
+            [dst](size_t first, size_t last) {
+                std::uninitialized_value_construct_n(dst + first, last - first);
+            },
+            [dst](size_t first, size_t last) {
+                std::destroy_n(dst + first, last - first);
+            });
+    }
+
+    static void DefaultConstructElements(T* dst, size_t n) {
+        if constexpr (!std::is_trivially_default_constructible_v<T>) {
+            Execution::Transact(
+                n,
+                [dst](size_t first, size_t last) {
+                    std::uninitialized_default_construct_n(dst + first, last - first);
+                },
+                [dst](size_t first, size_t last) {
+                    std::destroy_n(dst + first, last - first);
+                });
+        }
+    }
+
+    template <typename InputIt>
+    static void CopyElements(InputIt src, size_t n, T* dst) {
+        if constexpr (detail::IS_RANDOM_ACCESS_ITERATOR<InputIt>) {
+            Execution::Transact(
+                n,
+                [src, dst](size_t first, size_t last) {
+                    std::uninitialized_copy_n(src + first, last - first, dst + first);
+                },
+                [dst](size_t first, size_t last) {
+                    std::destroy_n(dst + first, last - first);
+                });
+        } else {
+            std::uninitialized_copy_n(src, n, dst);
+        }
+    }
+
+    // Assigns over n constructed elements; elements assigned before an
+    // exception keep their new values
+    template <typename InputIt>
+    static void AssignElementsInPlace(InputIt src, size_t n, T* dst) {
+        if constexpr (detail::IS_RANDOM_ACCESS_ITERATOR<InputIt>) {
+            Execution::Transact(
+                n,
+                [src, dst](size_t first, size_t last) {
+                    std::copy_n(src + first, last - first, dst + first);
+                },
+                [](size_t, size_t) {
+                });
+        } else {
+            std::copy_n(src, n, dst);
+        }
+    }
+
+    static void DestroyElements(T* data, size_t n) noexcept {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            Execution::ForEach(n, [data](size_t first, size_t last) {
+                std::destroy_n(data + first, last - first);
+            });
+        }
+    }
+
+    // Moves, or copies when moving may throw, n elements to dst and leaves
+    // the source intact
+    static void TransferElements(T* src, size_t n, T* dst) {
+        if constexpr (is_trivially_relocatable_v<T>) {
+            Execution::ForEach(n, [src, dst](size_t first, size_t last) {
+                if (first != last) {
+                    std::memcpy(static_cast<void*>(dst + first), static_cast<const void*>(src + first),
+                                (last - first) * sizeof(T));
+                }
+            });
         } else {
-            new (data_ + index) T(std::forward<Args>(args)...);
+            Execution::Transact(
+                n,
+                [src, dst](size_t first, size_t last) {
+                    detail::UninitializedMoveIfNoexceptN(src + first, last - first, dst + first);
+                },
+                [dst](size_t first, size_t last) {
+                    std::destroy_n(dst + first, last - first);
+                });
+        }
+    }
+
+    // Same contract as detail::RelocateN
+    static void RelocateElements(T* src, size_t n, T* dst) {
+        TransferElements(src, n, dst);
+        if constexpr (!is_trivially_relocatable_v<T>) {
+            DestroyElements(src, n);
         }
     }
 
+    // Same contract as detail::RelocateWithGap
+    static void RelocateWithGap(T* src, size_t n, size_t index, T* dst, size_t gap_size) {
+        assert(index <= n);
+        TransferElements(src, index, dst);
+        try {
+            TransferElements(src + index, n - index, dst + index + gap_size);
+        } catch (...) {
+            if constexpr (!is_trivially_relocatable_v<T>) {
+                DestroyElements(dst, index);
+            }
+            throw;
+        }
+        if constexpr (!is_trivially_relocatable_v<T>) {
+            DestroyElements(src, n);
+        }
+    }
 };
@@ -0,0 +1,436 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+
+// Bulk algorithms over contiguous ranges (Vector, SmallVector, SoAVector
+// columns, ...). For 32- and 64-bit arithmetic element types they run
+// vectorized kernels chosen at run time for the widest instruction set the
+// CPU supports; other types use the std algorithms.
+//
+// Floating-point Sum adds lanes in a different order than a sequential loop,
+// so results may differ in the last bits. MinMax of ranges containing NaN is
+// unspecified.
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ADVANCED_VECTOR_SIMD_X86 1
+#elif defined(__GNUC__) && defined(__ARM_NEON)
+#define ADVANCED_VECTOR_SIMD_NEON 1
+#endif
+
+enum class SimdLevel {
+    SCALAR,
+    SSE2,
+    AVX2,
+    AVX512,
+    NEON,
+};
+
+// Widest instruction set usable on this CPU
+inline SimdLevel DetectSimdLevel() noexcept {
+#if defined(ADVANCED_VECTOR_SIMD_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return SimdLevel::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return SimdLevel::SSE2;
+    }
+#elif defined(ADVANCED_VECTOR_SIMD_NEON)
+    return SimdLevel::NEON;
+#endif
+    return SimdLevel::SCALAR;
+}
+
+namespace detail {
+
+inline std::atomic<SimdLevel>& ActiveSimdLevel() noexcept {
+    static std::atomic<SimdLevel> level{DetectSimdLevel()};
+    return level;
+}
+
+inline bool IsSimdLevelSupported(SimdLevel level) noexcept {
+    const SimdLevel detected = DetectSimdLevel();
+    if (level == SimdLevel::SCALAR || level == detected) {
+        return true;
+    }
+    return detected != SimdLevel::NEON && level != SimdLevel::NEON && level < detected;
+}
+
+}  // namespace detail
+
+inline SimdLevel GetSimdLevel() noexcept {
+    return detail::ActiveSimdLevel().load(std::memory_order_relaxed);
+}
+
+// Limits the kernels to `level`, e.g. to compare instruction sets in tests
+// and benchmarks. Levels the CPU does not support are ignored.
+inline bool SetSimdLevel(SimdLevel level) noexcept {
+    if (!detail::IsSimdLevelSupported(level)) {
+        return false;
+    }
+    detail::ActiveSimdLevel().store(level, std::memory_order_relaxed);
+    return true;
+}
+
+namespace detail {
+
+template <typename T>
+inline constexpr bool IS_SIMD_ELEMENT =
+    std::is_arithmetic_v<T> && !std::is_same_v<T, bool> && (sizeof(T) == 4 || sizeof(T) == 8);
+
+template <typename T>
+struct ScalarKernels {
+    static void Fill(T* data, size_t n, const T& value) {
+        std::fill_n(data, n, value);
+    }
+
+    static size_t Find(const T* data, size_t n, const T& value) {
+        return std::find(data, data + n, value) - data;
+    }
+
+    static size_t Count(const T* data, size_t n, const T& value) {
+        return std::count(data, data + n, value);
+    }
+
+    static T Sum(const T* data, size_t n) {
+        return std::accumulate(data, data + n, T{});
+    }
+
+    static std::pair<T, T> MinMax(const T* data, size_t n) {
+        const auto [min, max] = std::minmax_element(data, data + n);
+        return {*min, *max};
+    }
+
+    template <typename U, typename Op>
+    static void Transform(const T* data, size_t n, U* out, Op& op) {
+        std::transform(data, data + n, out, op);
+    }
+};
+
+#if defined(ADVANCED_VECTOR_SIMD_X86) || defined(ADVANCED_VECTOR_SIMD_NEON)
+
+// Kernels over Bytes-wide GCC vector extension types. They are always inlined
+// into the per-instruction-set entry points below, which compile them for
+// their target.
+template <typename T, size_t Bytes>
+struct SimdKernels {
+    typedef T Vec __attribute__((vector_size(Bytes)));
+    using Mask = decltype(Vec{} == Vec{});
+
+    static constexpr size_t LANES = Bytes / sizeof(T);
+    // Count drains its lane counters before they can overflow
+    static constexpr size_t COUNT_BLOCK = size_t{1} << 20;
+
+    __attribute__((always_inline)) static inline void Fill(T* data, size_t n, T value) {
+        const Vec v = Vec{} + value;
+        size_t i = 0;
+        for (; i + LANES <= n; i += LANES) {
+            std::memcpy(data + i, &v, sizeof(Vec));
+        }
+        for (; i < n; ++i) {
+            data[i] = value;
+        }
+    }
+
+    __attribute__((always_inline)) static inline size_t Find(const T* data, size_t n, T value) {
+        const Vec needle = Vec{} + value;
+        size_t i = 0;
+        for (; i + LANES <= n; i += LANES) {
+            Vec v;
+            std::memcpy(&v, data + i, sizeof(Vec));
+            const Mask hits = v == needle;
+            uint64_t words[Bytes / 8];
+            std::memcpy(words, &hits, sizeof(words));
+            uint64_t any = 0;
+            for (uint64_t word : words) {
+                any |= word;
+            }
+            if (any != 0) {
+                break;
+            }
+        }
+        for (; i < n; ++i) {
+            if (data[i] == value) {
+                return i;
+            }
+        }
+        return n;
+    }
+
+    __attribute__((always_inline)) static inline size_t Count(const T* data, size_t n, T value) {
+        const Vec needle = Vec{} + value;
+        size_t count = 0;
+        size_t i = 0;
+        while (i + LANES <= n) {
+            // Matching lanes compare to -1
+            Mask lane_counts = {};
+            const size_t block_end = i + std::min(n - i, COUNT_BLOCK * LANES) / LANES * LANES;
+            for (; i < block_end; i += LANES) {
+                Vec v;
+                std::memcpy(&v, data + i, sizeof(Vec));
+                lane_counts -= v == needle;
+            }
+            for (size_t lane = 0; lane < LANES; ++lane) {
+                count += static_cast<size_t>(lane_counts[lane]);
+            }
+        }
+        for (; i < n; ++i) {
+            count += data[i] == value;
+        }
+        return count;
+    }
+
+    __attribute__((always_inline)) static inline T Sum(const T* data, size_t n) {
+        // Two accumulators hide the latency of dependent additions
+        Vec acc0 = {};
+        Vec acc1 = {};
+        size_t i = 0;
+        for (; i + 2 * LANES <= n; i += 2 * LANES) {
+            Vec v0;
+            Vec v1;
+            std::memcpy(&v0, data + i, sizeof(Vec));
+            std::memcpy(&v1, data + i + LANES, sizeof(Vec));
+            acc0 += v0;
+            acc1 += v1;
+        }
+        acc0 += acc1;
+        T sum{};
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            sum += acc0[lane];
+        }
+        for (; i < n; ++i) {
+            sum += data[i];
+        }
+        return sum;
+    }
+
+    __attribute__((always_inline)) static inline std::pair<T, T> MinMax(const T* data, size_t n) {
+        Vec min = Vec{} + data[0];
+        Vec max = min;
+        size_t i = 0;
+        for (; i + LANES <= n; i += LANES) {
+            Vec v;
+            std::memcpy(&v, data + i, sizeof(Vec));
+            min = v < min ? v : min;
+            max = v > max ? v : max;
+        }
+        T min_value = min[0];
+        T max_value = max[0];
+        for (size_t lane = 1; lane < LANES; ++lane) {
+            min_value = std::min<T>(min_value, min[lane]);
+            max_value = std::max<T>(max_value, max[lane]);
+        }
+        for (; i < n; ++i) {
+            min_value = std::min(min_value, data[i]);
+            max_value = std::max(max_value, data[i]);
+        }
+        return {min_value, max_value};
+    }
+
+    // Left to the auto-vectorizer, which sees the target of the caller
+    template <typename U, typename Op>
+    __attribute__((always_inline)) static inline void Transform(const T* data, size_t n, U* out, Op& op) {
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = op(data[i]);
+        }
+    }
+};
+
+#endif
+
+#if defined(ADVANCED_VECTOR_SIMD_X86)
+
+#define ADVANCED_VECTOR_SIMD_ENTRY_POINTS(TARGET, BYTES)                                        \
+    __attribute__((target(TARGET))) static void Fill(T* data, size_t n, T value) {              \
+        SimdKernels<T, BYTES>::Fill(data, n, value);                                            \
+    }                                                                                           \
+    __attribute__((target(TARGET))) static size_t Find(const T* data, size_t n, T value) {      \
+        return SimdKernels<T, BYTES>::Find(data, n, value);                                     \
+    }                                                                                           \
+    __attribute__((target(TARGET))) static size_t Count(const T* data, size_t n, T value) {     \
+        return SimdKernels<T, BYTES>::Count(data, n, value);                                    \
+    }                                                                                           \
+    __attribute__((target(TARGET))) static T Sum(const T* data, size_t n) {                     \
+        return SimdKernels<T, BYTES>::Sum(data, n);                                             \
+    }                                                                                           \
+    __attribute__((target(TARGET))) static std::pair<T, T> MinMax(const T* data, size_t n) {    \
+        return SimdKernels<T, BYTES>::MinMax(data, n);                                          \
+    }                                                                                           \
+    template <typename U, typename Op>                                                          \
+    __attribute__((target(TARGET))) static void Transform(const T* data, size_t n, U* out, Op& op) { \
+        SimdKernels<T, BYTES>::Transform(data, n, out, op);                                     \
+    }
+
+template <typename T>
+struct Sse2Kernels {
+    ADVANCED_VECTOR_SIMD_ENTRY_POINTS("sse2", 16)
+};
+
+template <typename T>
+struct Avx2Kernels {
+    ADVANCED_VECTOR_SIMD_ENTRY_POINTS("avx2", 32)
+};
+
+template <typename T>
+struct Avx512Kernels {
+    ADVANCED_VECTOR_SIMD_ENTRY_POINTS("avx512f", 64)
+};
+
+#undef ADVANCED_VECTOR_SIMD_ENTRY_POINTS
+
+#elif defined(ADVANCED_VECTOR_SIMD_NEON)
+
+// NEON is part of the baseline, so the kernels need no target attribute
+template <typename T>
+struct NeonKernels : SimdKernels<T, 16> {
+};
+
+#endif
+
+// Calls call(kernels) with the kernel set of the active instruction set
+template <typename T, typename Call>
+decltype(auto) DispatchKernels(Call&& call) {
+    if constexpr (IS_SIMD_ELEMENT<T>) {
+        switch (GetSimdLevel()) {
+#if defined(ADVANCED_VECTOR_SIMD_X86)
+            case SimdLevel::AVX512:
+                return call(Avx512Kernels<T>{});
+            case SimdLevel::AVX2:
+                return call(Avx2Kernels<T>{});
+            case SimdLevel::SSE2:
+                return call(Sse2Kernels<T>{});
+#elif defined(ADVANCED_VECTOR_SIMD_NEON)
+            case SimdLevel::NEON:
+                return call(NeonKernels<T>{});
+#endif
+            default:
+                break;
+        }
+    }
+    return call(ScalarKernels<T>{});
+}
+
+template <typename Container, typename = void>
+struct HasData : std::false_type {
+};
+
+template <typename Container>
+struct HasData<Container, std::void_t<decltype(std::declval<Container&>().Data())>> : std::true_type {
+};
+
+// Pointer to the first element: Data() where the container provides it, as
+// its iterators may be checked objects, begin() otherwise
+template <typename Container>
+auto ContiguousBegin(Container& container) noexcept {
+    if constexpr (HasData<Container>::value) {
+        return container.Data();
+    } else {
+        return container.begin();
+    }
+}
+
+template <typename Container>
+auto ContiguousEnd(Container& container) noexcept {
+    return ContiguousBegin(container) + (container.end() - container.begin());
+}
+
+template <typename Container>
+using ContiguousElement = std::remove_pointer_t<decltype(ContiguousBegin(std::declval<Container&>()))>;
+
+template <typename Container>
+using RequireContiguous = std::enable_if_t<std::is_pointer_v<decltype(ContiguousBegin(std::declval<Container&>()))>>;
+
+}  // namespace detail
+
+template <typename T>
+void Fill(T* first, T* last, const T& value) {
+    detail::DispatchKernels<T>([&](auto kernels) {
+        kernels.Fill(first, last - first, value);
+    });
+}
+
+template <typename T>
+const T* Find(const T* first, const T* last, const T& value) {
+    return first + detail::DispatchKernels<T>([&](auto kernels) {
+               return kernels.Find(first, last - first, value);
+           });
+}
+
+template <typename T>
+size_t Count(const T* first, const T* last, const T& value) {
+    return detail::DispatchKernels<T>([&](auto kernels) {
+        return kernels.Count(first, last - first, value);
+    });
+}
+
+template <typename T>
+T Sum(const T* first, const T* last) {
+    return detail::DispatchKernels<T>([&](auto kernels) {
+        return kernels.Sum(first, last - first);
+    });
+}
+
+// Returns {smallest, largest}; the range must not be empty
+template <typename T>
+std::pair<T, T> MinMax(const T* first, const T* last) {
+    assert(first != last);
+    return detail::DispatchKernels<T>([&](auto kernels) {
+        return kernels.MinMax(first, last - first);
+    });
+}
+
+// Writes op(x) for every x of [first, last) to out
+template <typename T, typename U, typename Op>
+void Transform(const T* first, const T* last, U* out, Op op) {
+    detail::DispatchKernels<T>([&](auto kernels) {
+        kernels.Transform(first, last - first, out, op);
+    });
+}
+
+// Container overloads for Vector and other contiguous containers
+
+template <typename Container, typename T = detail::ContiguousElement<Container>,
+          typename = detail::RequireContiguous<Container>>
+void Fill(Container& container, const T& value) {
+    Fill(detail::ContiguousBegin(container), detail::ContiguousEnd(container), value);
+}
+
+template <typename Container, typename T = detail::ContiguousElement<const Container>,
+          typename = detail::RequireContiguous<const Container>>
+const T* Find(const Container& container, const std::remove_const_t<T>& value) {
+    return Find<std::remove_const_t<T>>(detail::ContiguousBegin(container), detail::ContiguousEnd(container), value);
+}
+
+template <typename Container, typename T = detail::ContiguousElement<const Container>,
+          typename = detail::RequireContiguous<const Container>>
+size_t Count(const Container& container, const std::remove_const_t<T>& value) {
+    return Count<std::remove_const_t<T>>(detail::ContiguousBegin(container), detail::ContiguousEnd(container), value);
+}
+
+template <typename Container, typename T = detail::ContiguousElement<const Container>,
+          typename = detail::RequireContiguous<const Container>>
+std::remove_const_t<T> Sum(const Container& container) {
+    return Sum<std::remove_const_t<T>>(detail::ContiguousBegin(container), detail::ContiguousEnd(container));
+}
+
+template <typename Container, typename T = detail::ContiguousElement<const Container>,
+          typename = detail::RequireContiguous<const Container>>
+std::pair<std::remove_const_t<T>, std::remove_const_t<T>> MinMax(const Container& container) {
+    return MinMax<std::remove_const_t<T>>(detail::ContiguousBegin(container), detail::ContiguousEnd(container));
+}
+
+template <typename Container, typename U, typename Op, typename = detail::RequireContiguous<const Container>>
+void Transform(const Container& container, U* out, Op op) {
+    Transform(detail::ContiguousBegin(container), detail::ContiguousEnd(container), out, std::move(op));
+}
@@ -0,0 +1,285 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// Run-time checks of the containers, selected per build with
+// ADVANCED_VECTOR_CHECK_LEVEL:
+//     ADVANCED_VECTOR_CHECKS_OFF (0)
+//         No checks; element access is plain pointer arithmetic.
+//     ADVANCED_VECTOR_CHECKS_BOUNDS (1)
+//         Indices and positions passed to the containers are checked.
+//     ADVANCED_VECTOR_CHECKS_FULL (2)
+//         Also Vector iterators become checked objects that catch use after
+//         the vector reallocated or was destroyed, dereferencing outside
+//         [begin(), end()) and mixing iterators of different vectors.
+// The level defaults to BOUNDS, or OFF when NDEBUG is defined. A failed check
+// prints its location and aborts, also in release builds.
+//
+// Independently of the level, builds with AddressSanitizer mark the unused
+// capacity of Vector as a container overflow region
+// (__sanitizer_annotate_contiguous_container), so reads and writes past
+// Size() are reported even though the memory is allocated. Define
+// ADVANCED_VECTOR_ANNOTATE_CONTAINERS to 0 to turn the annotations off, e.g.
+// when some code that writes to a Vector's buffer is not instrumented.
+
+#define ADVANCED_VECTOR_CHECKS_OFF 0
+#define ADVANCED_VECTOR_CHECKS_BOUNDS 1
+#define ADVANCED_VECTOR_CHECKS_FULL 2
+
+#if !defined(ADVANCED_VECTOR_CHECK_LEVEL)
+#if defined(NDEBUG)
+#define ADVANCED_VECTOR_CHECK_LEVEL ADVANCED_VECTOR_CHECKS_OFF
+#else
+#define ADVANCED_VECTOR_CHECK_LEVEL ADVANCED_VECTOR_CHECKS_BOUNDS
+#endif
+#endif
+
+#if ADVANCED_VECTOR_CHECK_LEVEL >= ADVANCED_VECTOR_CHECKS_BOUNDS
+#define ADVANCED_VECTOR_CHECK(condition) \
+    ((condition) ? static_cast<void>(0) : ::detail::CheckFailed(__FILE__, __LINE__, #condition))
+#else
+#define ADVANCED_VECTOR_CHECK(condition) static_cast<void>(0)
+#endif
+
+#if !defined(ADVANCED_VECTOR_ANNOTATE_CONTAINERS)
+#if defined(__SANITIZE_ADDRESS__)
+#define ADVANCED_VECTOR_ANNOTATE_CONTAINERS 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define ADVANCED_VECTOR_ANNOTATE_CONTAINERS 1
+#endif
+#endif
+#endif
+
+#if !defined(ADVANCED_VECTOR_ANNOTATE_CONTAINERS)
+#define ADVANCED_VECTOR_ANNOTATE_CONTAINERS 0
+#endif
+
+#if ADVANCED_VECTOR_ANNOTATE_CONTAINERS
+#include <sanitizer/common_interface_defs.h>
+#endif
+
+namespace detail {
+
+[[noreturn]] inline void CheckFailed(const char* file, int line, const char* condition) noexcept {
+    std::fprintf(stderr, "%s:%d: advanced-vector check failed: %s\n", file, line, condition);
+    std::abort();
+}
+
+// Moves the boundary between the elements and the poisoned slack of
+// [data, data + capacity) from old_size to new_size. AddressSanitizer needs
+// the buffer to start on an 8-byte granule and either end on one or at the
+// end of a heap allocation; other buffers are left unannotated.
+template <typename T>
+void AnnotateContiguousContainer(const T* data, size_t capacity, size_t old_size, size_t new_size,
+                                 [[maybe_unused]] bool ends_allocation) noexcept {
+#if ADVANCED_VECTOR_ANNOTATE_CONTAINERS
+    constexpr uintptr_t GRANULE = 8;
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(data);
+    const uintptr_t end = reinterpret_cast<uintptr_t>(data + capacity);
+    if (data == nullptr || old_size == new_size || begin % GRANULE != 0 || (!ends_allocation && end % GRANULE != 0)) {
+        return;
+    }
+    __sanitizer_annotate_contiguous_container(data, data + capacity, data + old_size, data + new_size);
+#else
+    static_cast<void>(data);
+    static_cast<void>(capacity);
+    static_cast<void>(old_size);
+    static_cast<void>(new_size);
+#endif
+}
+
+// Identity of a container shared with its checked iterators. The container
+// resets it when destroyed, and hands it over together with its buffer, so
+// iterators keep following their elements after a move or a swap.
+class IteratorOwner {
+public:
+    explicit IteratorOwner(const void* container)
+        : state_(std::make_shared<const void*>(container))
+    {
+    }
+
+    IteratorOwner(const IteratorOwner&) = delete;
+    IteratorOwner& operator=(const IteratorOwner&) = delete;
+
+    ~IteratorOwner() {
+        *state_ = nullptr;
+    }
+
+    // Exchanges the iterators of two containers whose buffers were exchanged
+    void Swap(IteratorOwner& other) noexcept {
+        std::swap(state_, other.state_);
+        std::swap(*state_, *other.state_);
+    }
+
+    const std::shared_ptr<const void*>& GetState() const noexcept {
+        return state_;
+    }
+
+private:
+    std::shared_ptr<const void*> state_;
+};
+
+// Random-access iterator over the elements of Owner, which provides Data()
+// and Size(). It remembers the buffer it was created for, so it becomes
+// invalid once the owner reallocates.
+template <typename Owner, typename T>
+class CheckedIterator {
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::remove_const_t<T>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+
+    CheckedIterator() = default;
+
+    CheckedIterator(T* ptr, const Owner& owner, std::shared_ptr<const void*> state) noexcept
+        : ptr_(ptr)
+        , buffer_(owner.Data())
+        , state_(std::move(state))
+    {
+    }
+
+    template <typename U, typename = std::enable_if_t<std::is_same_v<const U, T> && !std::is_same_v<U, T>>>
+    CheckedIterator(const CheckedIterator<Owner, U>& other) noexcept
+        : ptr_(other.ptr_)
+        , buffer_(other.buffer_)
+        , state_(other.state_)
+    {
+    }
+
+    reference operator*() const noexcept {
+        CheckDereferenceable(ptr_);
+        return *ptr_;
+    }
+
+    pointer operator->() const noexcept {
+        CheckDereferenceable(ptr_);
+        return ptr_;
+    }
+
+    reference operator[](difference_type offset) const noexcept {
+        CheckDereferenceable(ptr_ + offset);
+        return ptr_[offset];
+    }
+
+    CheckedIterator& operator++() noexcept {
+        return *this += 1;
+    }
+
+    CheckedIterator operator++(int) noexcept {
+        CheckedIterator old = *this;
+        *this += 1;
+        return old;
+    }
+
+    CheckedIterator& operator--() noexcept {
+        return *this -= 1;
+    }
+
+    CheckedIterator operator--(int) noexcept {
+        CheckedIterator old = *this;
+        *this -= 1;
+        return old;
+    }
+
+    CheckedIterator& operator+=(difference_type offset) noexcept {
+        const Owner& owner = GetOwner();
+        ADVANCED_VECTOR_CHECK(offset >= owner.Data() - ptr_ && offset <= owner.Data() + owner.Size() - ptr_);
+        ptr_ += offset;
+        return *this;
+    }
+
+    CheckedIterator& operator-=(difference_type offset) noexcept {
+        return *this += -offset;
+    }
+
+    friend CheckedIterator operator+(CheckedIterator it, difference_type offset) noexcept {
+        return it += offset;
+    }
+
+    friend CheckedIterator operator+(difference_type offset, CheckedIterator it) noexcept {
+        return it += offset;
+    }
+
+    friend CheckedIterator operator-(CheckedIterator it, difference_type offset) noexcept {
+        return it -= offset;
+    }
+
+    friend difference_type operator-(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        lhs.CheckComparable(rhs);
+        return lhs.ptr_ - rhs.ptr_;
+    }
+
+    friend bool operator==(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        lhs.CheckComparable(rhs);
+        return lhs.ptr_ == rhs.ptr_;
+    }
+
+    friend bool operator!=(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+
+    friend bool operator<(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        return lhs - rhs < 0;
+    }
+
+    friend bool operator>(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        return rhs < lhs;
+    }
+
+    friend bool operator<=(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        return !(rhs < lhs);
+    }
+
+    friend bool operator>=(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        return !(lhs < rhs);
+    }
+
+    // The element pointer after checking that the iterator is valid and
+    // belongs to owner
+    T* Base(const Owner& owner) const noexcept {
+        ADVANCED_VECTOR_CHECK(&GetOwner() == &owner);
+        return ptr_;
+    }
+
+private:
+    template <typename, typename>
+    friend class CheckedIterator;
+
+    T* ptr_ = nullptr;
+    const void* buffer_ = nullptr;
+    std::shared_ptr<const void*> state_;
+
+    const Owner& GetOwner() const noexcept {
+        ADVANCED_VECTOR_CHECK(state_ != nullptr && *state_ != nullptr);
+        const Owner& owner = *static_cast<const Owner*>(*state_);
+        ADVANCED_VECTOR_CHECK(buffer_ == owner.Data());
+        return owner;
+    }
+
+    void CheckDereferenceable(const T* ptr) const noexcept {
+        const Owner& owner = GetOwner();
+        ADVANCED_VECTOR_CHECK(owner.Data() <= ptr && ptr < owner.Data() + owner.Size());
+    }
+
+    void CheckComparable(const CheckedIterator& other) const noexcept {
+        ADVANCED_VECTOR_CHECK(state_ == other.state_);
+        if (state_ == nullptr) {
+            // Value-initialized iterators compare equal
+            return;
+        }
+        GetOwner();
+        other.GetOwner();
+    }
+};
+
+}  // namespace detail
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+// Instrumentation policies receive Vector's hot-path events:
+//     OnReallocation(old_capacity, new_capacity, relocated_bytes)
+//     OnElementsShifted(count)       elements moved by Emplace/Insert/Erase
+//     OnSizeChanged(size, capacity)  after every operation that grows the size
+// NoInstrumentation has empty inline hooks, so instrumentation costs nothing
+// unless a policy is chosen explicitly.
+
+struct NoInstrumentation {
+    static void OnReallocation(size_t, size_t, size_t) noexcept {
+    }
+
+    static void OnElementsShifted(size_t) noexcept {
+    }
+
+    static void OnSizeChanged(size_t, size_t) noexcept {
+    }
+};
+
+struct VectorStats {
+    size_t reallocations = 0;
+    size_t relocated_bytes = 0;
+    size_t shifted_elements = 0;
+    size_t peak_size = 0;
+    size_t peak_capacity = 0;
+};
+
+namespace detail {
+
+class VectorStatsCounters {
+public:
+    void AddReallocation(size_t new_capacity, size_t relocated_bytes) noexcept {
+        reallocations_.fetch_add(1, std::memory_order_relaxed);
+        relocated_bytes_.fetch_add(relocated_bytes, std::memory_order_relaxed);
+        UpdatePeak(peak_capacity_, new_capacity);
+    }
+
+    void AddShiftedElements(size_t count) noexcept {
+        shifted_elements_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void UpdateSize(size_t size, size_t capacity) noexcept {
+        UpdatePeak(peak_size_, size);
+        UpdatePeak(peak_capacity_, capacity);
+    }
+
+    VectorStats Load() const noexcept {
+        return {reallocations_.load(std::memory_order_relaxed), relocated_bytes_.load(std::memory_order_relaxed),
+                shifted_elements_.load(std::memory_order_relaxed), peak_size_.load(std::memory_order_relaxed),
+                peak_capacity_.load(std::memory_order_relaxed)};
+    }
+
+    void Reset() noexcept {
+        reallocations_.store(0, std::memory_order_relaxed);
+        relocated_bytes_.store(0, std::memory_order_relaxed);
+        shifted_elements_.store(0, std::memory_order_relaxed);
+        peak_size_.store(0, std::memory_order_relaxed);
+        peak_capacity_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static void UpdatePeak(std::atomic<size_t>& peak, size_t value) noexcept {
+        size_t current = peak.load(std::memory_order_relaxed);
+        while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    std::atomic<size_t> reallocations_{0};
+    std::atomic<size_t> relocated_bytes_{0};
+    std::atomic<size_t> shifted_elements_{0};
+    std::atomic<size_t> peak_size_{0};
+    std::atomic<size_t> peak_capacity_{0};
+};
+
+struct InstrumentedSite {
+    std::string name;
+    const VectorStatsCounters* counters;
+};
+
+class InstrumentedSiteRegistry {
+public:
+    static InstrumentedSiteRegistry& Instance() {
+        static InstrumentedSiteRegistry registry;
+        return registry;
+    }
+
+    void Register(std::string name, const VectorStatsCounters* counters) {
+        std::lock_guard guard(mutex_);
+        sites_.push_back({std::move(name), counters});
+    }
+
+    template <typename Visitor>
+    void ForEach(Visitor&& visitor) const {
+        std::lock_guard guard(mutex_);
+        for (const InstrumentedSite& site : sites_) {
+            visitor(site.name, site.counters->Load());
+        }
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<InstrumentedSite> sites_;
+};
+
+template <typename Tag, typename = void>
+struct SiteName {
+    static std::string Get() {
+        return typeid(Tag).name();
+    }
+};
+
+template <typename Tag>
+struct SiteName<Tag, std::void_t<decltype(Tag::NAME)>> {
+    static std::string Get() {
+        return Tag::NAME;
+    }
+};
+
+}  // namespace detail
+
+// Aggregates the events of every Vector instantiated with the same Tag, so
+// a tag per call site gives per-site statistics:
+//     struct IngestSite { static constexpr const char* NAME = "ingest"; };
+//     Vector<Record, std::allocator<Record>, DoublingGrowth<>, CountingInstrumentation<IngestSite>> records;
+template <typename Tag>
+struct CountingInstrumentation {
+    static void OnReallocation(size_t, size_t new_capacity, size_t relocated_bytes) noexcept {
+        Counters().AddReallocation(new_capacity, relocated_bytes);
+    }
+
+    static void OnElementsShifted(size_t count) noexcept {
+        Counters().AddShiftedElements(count);
+    }
+
+    static void OnSizeChanged(size_t size, size_t capacity) noexcept {
+        Counters().UpdateSize(size, capacity);
+    }
+
+    static VectorStats GetStats() noexcept {
+        return Counters().Load();
+    }
+
+    static void Reset() noexcept {
+        Counters().Reset();
+    }
+
+private:
+    static detail::VectorStatsCounters& Counters() noexcept {
+        static detail::VectorStatsCounters& counters = RegisterCounters();
+        return counters;
+    }
+
+    static detail::VectorStatsCounters& RegisterCounters() noexcept {
+        static detail::VectorStatsCounters counters;
+        try {
+            detail::InstrumentedSiteRegistry::Instance().Register(detail::SiteName<Tag>::Get(), &counters);
+        } catch (...) {
+            // The site still counts, it is only missing from ForEachInstrumentedSite
+        }
+        return counters;
+    }
+};
+
+// Calls visitor(name, stats) for every call site that has recorded events
+template <typename Visitor>
+void ForEachInstrumentedSite(Visitor&& visitor) {
+    detail::InstrumentedSiteRegistry::Instance().ForEach(std::forward<Visitor>(visitor));
+}
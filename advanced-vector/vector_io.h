@@ -0,0 +1,482 @@
+#pragma once
+
+#include "vector.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Binary I/O of Vector through POSIX file descriptors (files, pipes, sockets)
+// or standard streams. A message starts with a header recording the format,
+// element size and element count, and ends right after the last element, so
+// several vectors can follow each other on one connection. Data is stored in
+// host byte order; the header magic makes a reader of the other byte order
+// fail instead of misreading.
+//
+// Elements that are trivially copyable and trivially default constructible
+// are written from the vector's buffer in a single writev() together with
+// the header, and read straight into the destination buffer through
+// ResizeAndOverwrite, without intermediate copies. Other elements are encoded
+// by Serializer into chunks of about SERIALIZATION_CHUNK_BYTES, so writing and
+// reading need only one chunk of scratch memory at a time.
+//
+// Headers and chunk boundaries are validated, but the sizes they carry are
+// trusted and may make ReadFrom allocate that much memory; limit the input
+// size when reading from untrusted peers.
+
+inline constexpr size_t SERIALIZATION_CHUNK_BYTES = 64 * 1024;
+
+struct VectorStreamHeader {
+    static constexpr uint32_t MAGIC = 0x31'43'45'56;  // "VEC1"
+    static constexpr uint16_t VERSION = 1;
+
+    enum Format : uint16_t {
+        // The elements' bytes follow the header
+        RAW = 0,
+        // Chunks follow, each a ChunkHeader and the encoded elements
+        CHUNKED = 1,
+    };
+
+    struct ChunkHeader {
+        uint64_t count;
+        uint64_t bytes;
+    };
+
+    uint32_t magic;
+    uint16_t version;
+    uint16_t format;
+    // sizeof(T) in the raw format, 0 in the chunked one
+    uint64_t element_size;
+    uint64_t count;
+};
+
+class ByteWriter;
+class ByteReader;
+
+// Encoding of one element in the chunked format. Trivially copyable
+// elements are stored as their bytes; std::basic_string, std::pair and
+// nested Vectors are provided. Other types specialize Serializer with
+//     static void Write(ByteWriter& out, const T& value);
+//     static T Read(ByteReader& in);
+template <typename T, typename = void>
+struct Serializer;
+
+namespace detail {
+
+template <typename T>
+inline constexpr bool IS_RAW_SERIALIZABLE =
+    std::is_trivially_copyable_v<T> && std::is_trivially_default_constructible_v<T>;
+
+// Keeps each system call below the size Linux transfers at once, so partial
+// transfers are the only case to handle
+inline constexpr size_t MAX_IO_BYTES = size_t{1} << 30;
+
+class FdSink {
+public:
+    explicit FdSink(int fd) noexcept
+        : fd_(fd)
+    {
+    }
+
+    // Writes head and then body, together in one writev() unless the kernel
+    // accepts less
+    void Write(const void* head, size_t head_size, const void* body, size_t body_size) {
+        iovec parts[2] = {{const_cast<void*>(head), head_size}, {const_cast<void*>(body), body_size}};
+        size_t first = parts[0].iov_len == 0 ? 1 : 0;
+        while (first < 2 && parts[first].iov_len != 0) {
+            iovec batch[2];
+            int num_parts = 0;
+            size_t batch_bytes = 0;
+            for (size_t i = first; i < 2 && batch_bytes < MAX_IO_BYTES; ++i) {
+                const size_t len = std::min(parts[i].iov_len, MAX_IO_BYTES - batch_bytes);
+                batch[num_parts++] = {parts[i].iov_base, len};
+                batch_bytes += len;
+            }
+            const ssize_t written = ::writev(fd_, batch, num_parts);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "writev");
+            }
+            size_t left = static_cast<size_t>(written);
+            for (; first < 2 && left >= parts[first].iov_len; ++first) {
+                left -= parts[first].iov_len;
+            }
+            if (first < 2) {
+                parts[first].iov_base = static_cast<char*>(parts[first].iov_base) + left;
+                parts[first].iov_len -= left;
+            }
+        }
+    }
+
+private:
+    int fd_;
+};
+
+class FdSource {
+public:
+    explicit FdSource(int fd) noexcept
+        : fd_(fd)
+    {
+    }
+
+    void Read(void* data, size_t size) {
+        char* dest = static_cast<char*>(data);
+        while (size > 0) {
+            const ssize_t num_read = ::read(fd_, dest, std::min(size, MAX_IO_BYTES));
+            if (num_read < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "read");
+            }
+            if (num_read == 0) {
+                throw std::runtime_error("unexpected end of Vector data");
+            }
+            dest += num_read;
+            size -= static_cast<size_t>(num_read);
+        }
+    }
+
+private:
+    int fd_;
+};
+
+class StreamSink {
+public:
+    explicit StreamSink(std::ostream& out) noexcept
+        : out_(out)
+    {
+    }
+
+    void Write(const void* head, size_t head_size, const void* body, size_t body_size) {
+        WritePart(head, head_size);
+        WritePart(body, body_size);
+    }
+
+private:
+    std::ostream& out_;
+
+    void WritePart(const void* data, size_t size) {
+        const char* src = static_cast<const char*>(data);
+        for (; size > 0 && out_; size -= std::min(size, MAX_IO_BYTES)) {
+            out_.write(src, static_cast<std::streamsize>(std::min(size, MAX_IO_BYTES)));
+            src += std::min(size, MAX_IO_BYTES);
+        }
+        if (!out_) {
+            throw std::runtime_error("writing Vector data to a stream failed");
+        }
+    }
+};
+
+class StreamSource {
+public:
+    explicit StreamSource(std::istream& in) noexcept
+        : in_(in)
+    {
+    }
+
+    void Read(void* data, size_t size) {
+        char* dest = static_cast<char*>(data);
+        while (size > 0) {
+            const size_t part = std::min(size, MAX_IO_BYTES);
+            in_.read(dest, static_cast<std::streamsize>(part));
+            if (static_cast<size_t>(in_.gcount()) != part) {
+                throw std::runtime_error("unexpected end of Vector data");
+            }
+            dest += part;
+            size -= part;
+        }
+    }
+
+private:
+    std::istream& in_;
+};
+
+}  // namespace detail
+
+// Destination of Serializer::Write: appends to the chunk being built
+class ByteWriter {
+public:
+    void WriteBytes(const void* data, size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        buffer_.Append(bytes, bytes + size);
+    }
+
+    template <typename T>
+    void Write(const T& value) {
+        Serializer<T>::Write(*this, value);
+    }
+
+    size_t Size() const noexcept {
+        return buffer_.Size();
+    }
+
+    const char* Data() const noexcept {
+        return buffer_.Data();
+    }
+
+    void Reserve(size_t capacity) {
+        buffer_.Reserve(capacity);
+    }
+
+    void Clear() noexcept {
+        buffer_.Clear();
+    }
+
+private:
+    Vector<char> buffer_;
+};
+
+// Source of Serializer::Read: consumes the chunk being decoded. Reading past
+// its end means the data is corrupt and throws std::runtime_error.
+class ByteReader {
+public:
+    ByteReader(const char* data, size_t size) noexcept
+        : pos_(data)
+        , end_(data + size)
+    {
+    }
+
+    void ReadBytes(void* data, size_t size) {
+        if (size > Remaining()) {
+            throw std::runtime_error("Vector data chunk is truncated");
+        }
+        if (size != 0) {
+            std::memcpy(data, pos_, size);
+            pos_ += size;
+        }
+    }
+
+    template <typename T>
+    T Read() {
+        return Serializer<T>::Read(*this);
+    }
+
+    size_t Remaining() const noexcept {
+        return static_cast<size_t>(end_ - pos_);
+    }
+
+private:
+    const char* pos_;
+    const char* end_;
+};
+
+template <typename T>
+struct Serializer<T, std::enable_if_t<std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>>> {
+    static void Write(ByteWriter& out, const T& value) {
+        out.WriteBytes(&value, sizeof(T));
+    }
+
+    static T Read(ByteReader& in) {
+        T value;
+        in.ReadBytes(&value, sizeof(T));
+        return value;
+    }
+};
+
+template <typename Char, typename Traits, typename Alloc>
+struct Serializer<std::basic_string<Char, Traits, Alloc>> {
+    static void Write(ByteWriter& out, const std::basic_string<Char, Traits, Alloc>& value) {
+        out.Write(static_cast<uint64_t>(value.size()));
+        out.WriteBytes(value.data(), value.size() * sizeof(Char));
+    }
+
+    static std::basic_string<Char, Traits, Alloc> Read(ByteReader& in) {
+        const uint64_t size = in.Read<uint64_t>();
+        if (size > in.Remaining() / sizeof(Char)) {
+            throw std::runtime_error("Vector data chunk is truncated");
+        }
+        std::basic_string<Char, Traits, Alloc> value(static_cast<size_t>(size), Char());
+        in.ReadBytes(value.data(), value.size() * sizeof(Char));
+        return value;
+    }
+};
+
+template <typename First, typename Second>
+struct Serializer<std::pair<First, Second>> {
+    static void Write(ByteWriter& out, const std::pair<First, Second>& value) {
+        out.Write(value.first);
+        out.Write(value.second);
+    }
+
+    static std::pair<First, Second> Read(ByteReader& in) {
+        First first = in.Read<First>();
+        Second second = in.Read<Second>();
+        return {std::move(first), std::move(second)};
+    }
+};
+
+template <typename T, typename Alloc, typename Growth, typename Instrumentation, typename Execution>
+struct Serializer<Vector<T, Alloc, Growth, Instrumentation, Execution>> {
+    using Type = Vector<T, Alloc, Growth, Instrumentation, Execution>;
+
+    static void Write(ByteWriter& out, const Type& value) {
+        out.Write(static_cast<uint64_t>(value.Size()));
+        if constexpr (detail::IS_RAW_SERIALIZABLE<T>) {
+            out.WriteBytes(value.Data(), value.Size() * sizeof(T));
+        } else {
+            for (const T& element : value) {
+                out.Write(element);
+            }
+        }
+    }
+
+    static Type Read(ByteReader& in) {
+        const uint64_t size = in.Read<uint64_t>();
+        Type value;
+        if constexpr (detail::IS_RAW_SERIALIZABLE<T>) {
+            if (size > in.Remaining() / sizeof(T)) {
+                throw std::runtime_error("Vector data chunk is truncated");
+            }
+            value.ResizeAndOverwrite(static_cast<size_t>(size), [&in](T* data, size_t n) {
+                in.ReadBytes(data, n * sizeof(T));
+                return n;
+            });
+        } else {
+            // Every element takes at least one byte, or the size is bogus
+            value.Reserve(static_cast<size_t>(std::min<uint64_t>(size, in.Remaining())));
+            for (uint64_t i = 0; i < size; ++i) {
+                value.EmplaceBack(in.Read<T>());
+            }
+        }
+        return value;
+    }
+};
+
+namespace detail {
+
+template <typename Sink, typename T, typename Alloc, typename Growth, typename Instrumentation, typename Execution>
+void WriteVector(Sink& sink, const Vector<T, Alloc, Growth, Instrumentation, Execution>& v) {
+    using Header = VectorStreamHeader;
+    if constexpr (IS_RAW_SERIALIZABLE<T>) {
+        const Header header = {Header::MAGIC, Header::VERSION, Header::RAW, sizeof(T), v.Size()};
+        sink.Write(&header, sizeof(header), v.Data(), v.Size() * sizeof(T));
+    } else {
+        const Header header = {Header::MAGIC, Header::VERSION, Header::CHUNKED, 0, v.Size()};
+        sink.Write(&header, sizeof(header), nullptr, 0);
+        ByteWriter out;
+        out.Reserve(SERIALIZATION_CHUNK_BYTES);
+        Header::ChunkHeader chunk = {0, 0};
+        const auto flush = [&] {
+            chunk.bytes = out.Size();
+            sink.Write(&chunk, sizeof(chunk), out.Data(), out.Size());
+            chunk.count = 0;
+            out.Clear();
+        };
+        for (const T& element : v) {
+            out.Write(element);
+            ++chunk.count;
+            if (out.Size() >= SERIALIZATION_CHUNK_BYTES) {
+                flush();
+            }
+        }
+        if (chunk.count != 0) {
+            flush();
+        }
+    }
+}
+
+template <typename Source, typename T, typename Alloc, typename Growth, typename Instrumentation, typename Execution>
+void ReadVector(Source& source, Vector<T, Alloc, Growth, Instrumentation, Execution>& v) {
+    using Header = VectorStreamHeader;
+    Header header;
+    source.Read(&header, sizeof(header));
+    if (header.magic != Header::MAGIC || header.version != Header::VERSION) {
+        throw std::runtime_error("not Vector data");
+    }
+    constexpr bool IS_RAW = IS_RAW_SERIALIZABLE<T>;
+    if (header.format != (IS_RAW ? Header::RAW : Header::CHUNKED) || header.element_size != (IS_RAW ? sizeof(T) : 0)) {
+        throw std::runtime_error("Vector data was written for another element type");
+    }
+    if (header.count > std::numeric_limits<size_t>::max() / sizeof(T)) {
+        throw std::runtime_error("Vector data holds more elements than fit in memory");
+    }
+    const size_t count = static_cast<size_t>(header.count);
+    try {
+        if constexpr (IS_RAW) {
+            // Elements land in the vector's own buffer, reusing its capacity.
+            // The old elements are overwritten anyway, so a growing buffer
+            // need not relocate them.
+            if (count > v.Capacity()) {
+                v.Clear();
+            }
+            v.ResizeAndOverwrite(count, [&source](T* data, size_t n) {
+                source.Read(data, n * sizeof(T));
+                return n;
+            });
+        } else {
+            v.Clear();
+            Vector<char> scratch;
+            while (v.Size() < count) {
+                Header::ChunkHeader chunk;
+                source.Read(&chunk, sizeof(chunk));
+                if (chunk.count == 0 || chunk.count > count - v.Size()) {
+                    throw std::runtime_error("Vector data chunk is corrupt");
+                }
+                scratch.ResizeAndOverwrite(static_cast<size_t>(chunk.bytes), [&source](char* data, size_t n) {
+                    source.Read(data, n);
+                    return n;
+                });
+                v.Reserve(v.Size() + static_cast<size_t>(std::min(chunk.count, chunk.bytes)));
+                ByteReader in(scratch.Data(), scratch.Size());
+                for (uint64_t i = 0; i < chunk.count; ++i) {
+                    v.EmplaceBack(Serializer<T>::Read(in));
+                }
+                if (in.Remaining() != 0) {
+                    throw std::runtime_error("Vector data chunk is corrupt");
+                }
+            }
+        }
+    } catch (...) {
+        v.Clear();
+        throw;
+    }
+}
+
+}  // namespace detail
+
+// Writes v to the file descriptor, retrying interrupted and partial writes.
+// Throws std::system_error when a write fails.
+template <typename T, typename Alloc, typename Growth, typename Instrumentation, typename Execution>
+void WriteTo(int fd, const Vector<T, Alloc, Growth, Instrumentation, Execution>& v) {
+    detail::FdSink sink(fd);
+    detail::WriteVector(sink, v);
+}
+
+// Throws std::runtime_error when the stream fails
+template <typename T, typename Alloc, typename Growth, typename Instrumentation, typename Execution>
+void WriteTo(std::ostream& out, const Vector<T, Alloc, Growth, Instrumentation, Execution>& v) {
+    detail::StreamSink sink(out);
+    detail::WriteVector(sink, v);
+}
+
+// Replaces the contents of v with the next vector written by WriteTo.
+// Trivial elements are read into v's buffer, which is reused when its
+// capacity suffices. Throws std::system_error when a read fails and
+// std::runtime_error on malformed or truncated data, leaving v empty.
+template <typename T, typename Alloc, typename Growth, typename Instrumentation, typename Execution>
+void ReadFrom(int fd, Vector<T, Alloc, Growth, Instrumentation, Execution>& v) {
+    detail::FdSource source(fd);
+    detail::ReadVector(source, v);
+}
+
+template <typename T, typename Alloc, typename Growth, typename Instrumentation, typename Execution>
+void ReadFrom(std::istream& in, Vector<T, Alloc, Growth, Instrumentation, Execution>& v) {
+    detail::StreamSource source(in);
+    detail::ReadVector(source, v);
+}
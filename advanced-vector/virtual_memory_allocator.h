@@ -0,0 +1,211 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+enum class HugePages {
+    NONE,
+    // Ask the kernel to back the range with transparent huge pages (Linux)
+    TRANSPARENT,
+    // Map the range from the hugetlbfs pool (Linux, pages must be preallocated)
+    EXPLICIT,
+};
+
+struct VirtualMemoryOptions {
+    // Address space reserved for every buffer; nothing is committed up front
+    size_t reserve_bytes = size_t{64} << 30;
+    HugePages huge_pages = HugePages::NONE;
+};
+
+// Allocator reserving a large virtual address range per buffer and committing
+// pages on demand. Vector grows such buffers through expand_in_place(), so
+// as long as the reservation suffices growth never relocates elements and
+// pointers and iterators into the vector stay valid.
+template <typename T>
+class VirtualMemoryAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    VirtualMemoryAllocator() noexcept = default;
+
+    explicit VirtualMemoryAllocator(VirtualMemoryOptions options) noexcept
+        : options_(options)
+    {
+    }
+
+    template <typename U>
+    VirtualMemoryAllocator(const VirtualMemoryAllocator<U>& other) noexcept
+        : options_(other.GetOptions())
+    {
+    }
+
+    T* allocate(size_t n) {
+        const size_t reserved = ReservedBytes(n);
+        const size_t committed = CommittedBytes(n);
+        void* base = Reserve(reserved);
+        if (!Commit(base, committed)) {
+            Release(base, reserved);
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(base);
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        // Cannot overflow for a capacity that allocate() accepted
+        size_t reserved = 0;
+        TryReservedBytes(n, reserved);
+        Release(p, reserved);
+    }
+
+    // Commits the pages needed for new_n elements if they fit into the
+    // reservation made when p was allocated
+    bool expand_in_place(T* p, size_t old_n, size_t new_n) noexcept {
+        size_t committed = 0;
+        size_t reserved = 0;
+        if (!TryCommittedBytes(new_n, committed) || !TryReservedBytes(old_n, reserved) || committed > reserved) {
+            return false;
+        }
+        return Commit(p, committed);
+    }
+
+    const VirtualMemoryOptions& GetOptions() const noexcept {
+        return options_;
+    }
+
+    template <typename U>
+    bool operator==(const VirtualMemoryAllocator<U>& other) const noexcept {
+        return options_.reserve_bytes == other.GetOptions().reserve_bytes
+            && options_.huge_pages == other.GetOptions().huge_pages;
+    }
+
+    template <typename U>
+    bool operator!=(const VirtualMemoryAllocator<U>& other) const noexcept {
+        return !(*this == other);
+    }
+
+private:
+    static constexpr size_t HUGE_PAGE_SIZE = size_t{2} << 20;
+
+    size_t Granularity() const noexcept {
+        if (options_.huge_pages != HugePages::NONE) {
+            return HUGE_PAGE_SIZE;
+        }
+#if defined(_WIN32)
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return info.dwPageSize;
+#else
+        return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    }
+
+    // The sizes below are false when they overflow size_t
+    bool TryRoundToPages(size_t bytes, size_t& rounded) const noexcept {
+        const size_t granularity = Granularity();
+        if (bytes > std::numeric_limits<size_t>::max() - granularity) {
+            return false;
+        }
+        rounded = (bytes + granularity - 1) / granularity * granularity;
+        return true;
+    }
+
+    bool TryCommittedBytes(size_t n, size_t& bytes) const noexcept {
+        return n <= std::numeric_limits<size_t>::max() / sizeof(T) && TryRoundToPages(n * sizeof(T), bytes);
+    }
+
+    // The reservation only depends on the options and on the capacity the
+    // buffer was allocated with, and growth never exceeds it, so deallocate
+    // can recompute it from the final capacity
+    bool TryReservedBytes(size_t n, size_t& bytes) const noexcept {
+        size_t committed = 0;
+        size_t reserve = 0;
+        if (!TryCommittedBytes(n, committed) || !TryRoundToPages(options_.reserve_bytes, reserve)) {
+            return false;
+        }
+        bytes = committed > reserve ? committed : reserve;
+        return true;
+    }
+
+    size_t CommittedBytes(size_t n) const {
+        size_t bytes = 0;
+        if (!TryCommittedBytes(n, bytes)) {
+            throw std::bad_array_new_length();
+        }
+        return bytes;
+    }
+
+    size_t ReservedBytes(size_t n) const {
+        size_t bytes = 0;
+        if (!TryReservedBytes(n, bytes)) {
+            throw std::bad_array_new_length();
+        }
+        return bytes;
+    }
+
+    void* Reserve(size_t bytes) const {
+#if defined(_WIN32)
+        void* base = VirtualAlloc(nullptr, bytes, MEM_RESERVE, PAGE_NOACCESS);
+        if (base == nullptr) {
+            throw std::bad_alloc();
+        }
+        return base;
+#else
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+#ifdef MAP_HUGETLB
+        if (options_.huge_pages == HugePages::EXPLICIT) {
+            flags |= MAP_HUGETLB;
+        }
+#endif
+        void* base = mmap(nullptr, bytes, PROT_NONE, flags, -1, 0);
+        if (base == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+#ifdef MADV_HUGEPAGE
+        if (options_.huge_pages == HugePages::TRANSPARENT) {
+            madvise(base, bytes, MADV_HUGEPAGE);
+        }
+#endif
+        return base;
+#endif
+    }
+
+    static bool Commit(void* base, size_t bytes) noexcept {
+        if (bytes == 0) {
+            return true;
+        }
+#if defined(_WIN32)
+        return VirtualAlloc(base, bytes, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+        return mprotect(base, bytes, PROT_READ | PROT_WRITE) == 0;
+#endif
+    }
+
+    static void Release(void* base, size_t bytes) noexcept {
+        if (base == nullptr) {
+            return;
+        }
+#if defined(_WIN32)
+        (void)bytes;
+        VirtualFree(base, 0, MEM_RELEASE);
+#else
+        munmap(base, bytes);
+#endif
+    }
+
+    VirtualMemoryOptions options_;
+};